@@ -0,0 +1,210 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Compares saving and loading objects through the binary format and a memory mapped store with
+// the text path that walks the property names.  Build in release mode for meaningful numbers.
+
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "meta/meta.h"
+#include "meta/meta_binary.h"
+#include "meta/meta_store.h"
+
+namespace {
+
+class Record : public meta::MetaObject {
+  DECLARE_META_OBJECT(Record);
+
+public:
+  int getId() const {
+    return m_id;
+  }
+  void setId(int id) {
+    m_id = id;
+  }
+
+  int getOffset() const {
+    return m_offset;
+  }
+  void setOffset(int offset) {
+    m_offset = offset;
+  }
+
+  double getWeight() const {
+    return m_weight;
+  }
+  void setWeight(double weight) {
+    m_weight = weight;
+  }
+
+  bool isEnabled() const {
+    return m_enabled;
+  }
+  void setEnabled(bool enabled) {
+    m_enabled = enabled;
+  }
+
+  const std::string& getLabel() const {
+    return m_label;
+  }
+  void setLabel(const std::string& label) {
+    m_label = label;
+  }
+
+private:
+  int m_id = 0;
+  int m_offset = 0;
+  double m_weight = 0.0;
+  bool m_enabled = false;
+  std::string m_label;
+};
+
+} // namespace
+
+DEFINE_META_OBJECT(Record)
+    .addProperty<Record, int>("id", "", meta::PropertyEditorType::Integer, &Record::getId,
+                              &Record::setId)
+    .addProperty<Record, int>("offset", "", meta::PropertyEditorType::Integer,
+                              &Record::getOffset, &Record::setOffset)
+    .addProperty<Record, double>("weight", "", meta::PropertyEditorType::String,
+                                 &Record::getWeight, &Record::setWeight)
+    .addProperty<Record, bool>("enabled", "", meta::PropertyEditorType::Bool, &Record::isEnabled,
+                               &Record::setEnabled)
+    .addProperty<Record, std::string>("label", "", meta::PropertyEditorType::String,
+                                      &Record::getLabel, &Record::setLabel);
+
+namespace {
+
+constexpr int kRecordCount = 200'000;
+
+template <typename Func> double measure(Func func) {
+  const auto start = std::chrono::steady_clock::now();
+  func();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+             .count() /
+         kRecordCount;
+}
+
+// Text form: one "name=value" line per property.
+void saveText(Record* record, std::string* out) {
+  std::set<std::string> names;
+  Record::GetStaticMetaBuilder()->getListOfProperties(&names);
+  std::string value;
+  for (const std::string& name : names) {
+    record->get(name, &value);
+    out->append(name);
+    out->push_back('=');
+    out->append(value);
+    out->push_back('\n');
+  }
+}
+
+void loadText(Record* record, std::string_view text) {
+  while (!text.empty()) {
+    const size_t end = text.find('\n');
+    const std::string_view line = text.substr(0, end);
+    const size_t separator = line.find('=');
+    record->set(line.substr(0, separator), line.substr(separator + 1));
+    text.remove_prefix(end + 1);
+  }
+}
+
+} // namespace
+
+int main() {
+  std::vector<Record> records(kRecordCount);
+  for (int i = 0; i < kRecordCount; ++i) {
+    records[i].setId(i);
+    records[i].setOffset(i % 200 - 100);
+    records[i].setWeight(i * 0.25);
+    records[i].setEnabled(i % 2 == 0);
+    records[i].setLabel("record");
+  }
+
+  std::vector<std::string> text(kRecordCount);
+  std::vector<std::string> binary(kRecordCount);
+  const meta::BinarySchema schema(Record::GetStaticMetaBuilder());
+  std::vector<Record> loaded(kRecordCount);
+
+  const double textSave = measure([&]() {
+    for (int i = 0; i < kRecordCount; ++i) {
+      saveText(&records[i], &text[i]);
+    }
+  });
+  const double binarySave = measure([&]() {
+    for (int i = 0; i < kRecordCount; ++i) {
+      schema.write(&records[i], &binary[i]);
+    }
+  });
+  const double textLoad = measure([&]() {
+    for (int i = 0; i < kRecordCount; ++i) {
+      loadText(&loaded[i], text[i]);
+    }
+  });
+  const double binaryLoad = measure([&]() {
+    for (int i = 0; i < kRecordCount; ++i) {
+      schema.read(&loaded[i], binary[i]);
+    }
+  });
+
+  size_t textBytes = 0;
+  size_t binaryBytes = 0;
+  for (int i = 0; i < kRecordCount; ++i) {
+    textBytes += text[i].size();
+    binaryBytes += binary[i].size();
+  }
+
+  // The store is written to a file and mapped back in.
+  std::vector<meta::MetaObject*> pointers;
+  for (Record& record : records) {
+    pointers.push_back(&record);
+  }
+  const char* storePath = "string_properties_bench_store.bin";
+  const double storeSave = measure(
+      [&]() { meta::PropertyStore::write(storePath, Record::GetStaticMetaBuilder(), pointers); });
+  meta::PropertyStore store;
+  const double storeOpen =
+      measure([&]() { store.open(storePath, Record::GetStaticMetaBuilder()); }) * kRecordCount;
+  const double storeLoad = measure([&]() {
+    for (int i = 0; i < kRecordCount; ++i) {
+      store.load(static_cast<size_t>(i), &loaded[i]);
+    }
+  });
+  store.close();
+  std::FILE* storeFile = std::fopen(storePath, "rb");
+  std::fseek(storeFile, 0, SEEK_END);
+  const double storeBytes = static_cast<double>(std::ftell(storeFile)) / kRecordCount;
+  std::fclose(storeFile);
+  std::remove(storePath);
+
+  std::printf("%-8s %10s %14s %14s\n", "format", "bytes/obj", "save ns/obj", "load ns/obj");
+  std::printf("%-8s %10.1f %14.1f %14.1f\n", "text", static_cast<double>(textBytes) / kRecordCount,
+              textSave, textLoad);
+  std::printf("%-8s %10.1f %14.1f %14.1f\n", "binary",
+              static_cast<double>(binaryBytes) / kRecordCount, binarySave, binaryLoad);
+  std::printf("%-8s %10.1f %14.1f %14.1f  (open %.3f ms)\n", "store", storeBytes, storeSave,
+              storeLoad, storeOpen / 1e6);
+
+  return 0;
+}
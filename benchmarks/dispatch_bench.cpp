@@ -0,0 +1,202 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Measures the cost of a single get/set call through the different lookup paths.  Build in
+// release mode for meaningful numbers.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "meta/meta.h"
+#include "meta/meta_query.h"
+
+namespace {
+
+class BenchObj : public meta::MetaObject {
+  DECLARE_META_OBJECT(BenchObj);
+
+public:
+  int getCount() const {
+    return m_count;
+  }
+  void setCount(int count) {
+    m_count = count;
+  }
+
+  bool isVisible() const {
+    return m_visible;
+  }
+  void setVisible(bool visible) {
+    m_visible = visible;
+  }
+
+private:
+  int m_count = 0;
+  bool m_visible = false;
+};
+
+} // namespace
+
+DEFINE_META_OBJECT(BenchObj)
+    .addProperty<BenchObj, int>("count", "", meta::PropertyEditorType::Integer,
+                                &BenchObj::getCount, &BenchObj::setCount)
+    .addProperty<BenchObj, bool>("visible", "", meta::PropertyEditorType::Bool,
+                                 &BenchObj::isVisible, &BenchObj::setVisible);
+
+namespace {
+
+constexpr int kIterations = 2'000'000;
+// Number of objects handled by each `measureColumn` call.
+constexpr size_t kColumnSize = 100'000;
+
+template <typename Func> void measure(const char* label, Func func) {
+  // Warm up.
+  for (int i = 0; i < kIterations / 10; ++i) {
+    func();
+  }
+
+#if defined(HAVE_RDTSC)
+  const uint64_t startCycles = __rdtsc();
+#endif
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    func();
+  }
+  const auto elapsed =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+#if defined(HAVE_RDTSC)
+  const uint64_t cycles = __rdtsc() - startCycles;
+  std::printf("%-28s %8.2f ns/call %8.1f cycles/call\n", label, elapsed.count() / kIterations,
+              static_cast<double>(cycles) / kIterations);
+#else
+  std::printf("%-28s %8.2f ns/call\n", label, elapsed.count() / kIterations);
+#endif
+}
+
+// Like `measure`, for a call that handles `kColumnSize` objects.
+template <typename Func> void measureColumn(const char* label, Func func) {
+  constexpr int kRepeats = 50;
+  func();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeats; ++i) {
+    func();
+  }
+  const auto elapsed =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+  std::printf("%-28s %8.2f ns/object\n", label, elapsed.count() / kRepeats / kColumnSize);
+}
+
+} // namespace
+
+int main() {
+  using namespace meta::literals;
+
+  BenchObj obj;
+  meta::MetaObject* metaObj = &obj;
+  std::string value;
+
+  const meta::PropertyHandle visible = BenchObj::GetStaticMetaBuilder()->resolve("visible");
+  const meta::PropertyHandle count = BenchObj::GetStaticMetaBuilder()->resolve("count");
+  const meta::PropertyName visibleName = "visible"_prop;
+
+  measure("get bool by name", [&]() { metaObj->get("visible", &value); });
+  measure("get bool by PropertyName", [&]() { metaObj->get(visibleName, &value); });
+  measure("get bool by handle", [&]() { metaObj->get(visible, &value); });
+  measure("set bool by name", [&]() { metaObj->set("visible", "true"); });
+  measure("set bool by handle", [&]() { metaObj->set(visible, "true"); });
+  measure("get int by handle", [&]() { metaObj->get(count, &value); });
+  measure("set int by handle", [&]() { metaObj->set(count, "50"); });
+
+  int typedCount = 0;
+  measure("get int typed by handle", [&]() { metaObj->get(count, &typedCount); });
+  measure("set int typed by handle", [&]() { metaObj->set(count, 50); });
+
+  measure("all by name list", [&]() {
+    std::set<std::string> names;
+    BenchObj::GetStaticMetaBuilder()->getListOfProperties(&names);
+    for (const std::string& name : names) {
+      std::string text;
+      metaObj->get(name, &text);
+    }
+  });
+  // One property across many objects.
+  std::vector<BenchObj> columnObjs(kColumnSize);
+  std::vector<meta::MetaObject*> columnPtrs;
+  for (size_t i = 0; i < kColumnSize; ++i) {
+    columnObjs[i].setCount(static_cast<int>(i));
+    columnPtrs.push_back(&columnObjs[i]);
+  }
+  std::vector<int> column(kColumnSize);
+  measureColumn("column by handle as text", [&]() {
+    for (size_t i = 0; i < kColumnSize; ++i) {
+      columnPtrs[i]->get(count, &value);
+      column[i] = static_cast<int>(value.size());
+    }
+  });
+  measureColumn("column typed by handle", [&]() {
+    for (size_t i = 0; i < kColumnSize; ++i) {
+      columnPtrs[i]->get(count, &column[i]);
+    }
+  });
+  measureColumn("column batch", [&]() {
+    BenchObj::GetStaticMetaBuilder()->getColumn(count, columnPtrs, &column);
+  });
+
+  // count > 50 && visible == true, as text and as a query.
+  for (size_t i = 0; i < kColumnSize; ++i) {
+    columnObjs[i].setCount(static_cast<int>(i % 100));
+    columnObjs[i].setVisible(i % 3 == 0);
+  }
+  std::vector<meta::MetaObject*> matches;
+  measureColumn("filter as text", [&]() {
+    matches.clear();
+    for (meta::MetaObject* obj : columnPtrs) {
+      obj->get(count, &value);
+      if (std::stoi(value) > 50) {
+        obj->get(visible, &value);
+        if (value == "true") {
+          matches.push_back(obj);
+        }
+      }
+    }
+  });
+  const meta::Query query = meta::Query(BenchObj::GetStaticMetaBuilder())
+                                .where(count, meta::CompareOp::Greater, 50)
+                                .where(visible, meta::CompareOp::Equal, true);
+  measureColumn("filter with query", [&]() {
+    matches.clear();
+    query.run(columnPtrs, &matches);
+  });
+
+  meta::Snapshot snapshot;
+  measure("all into snapshot",
+          [&]() { BenchObj::GetStaticMetaBuilder()->snapshot(metaObj, &snapshot); });
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Measures the collision rate and throughput of `meta::detail::hashName` over a corpus of property
+// names.  Pass one or more files with one name per line to use a real corpus; without arguments a
+// synthetic corpus of identifier style names is generated.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "meta/meta.h"
+
+namespace {
+
+// The byte at a time FNV-1a hash we used before, as a reference point.
+uint64_t fnv1a(const char* name, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(name[i])) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+std::vector<std::string> syntheticCorpus() {
+  static const char* const kWords[] = {
+      "name",   "count",  "visible", "position", "rotation", "scale",   "color",   "alpha",
+      "width",  "height", "depth",   "parent",   "child",    "index",   "offset",  "size",
+      "min",    "max",    "speed",   "velocity", "mass",     "enabled", "locked",  "selected",
+      "target", "source", "layer",   "mask",     "id",       "title",   "texture", "material",
+      "shadow", "light",  "camera",  "near",     "far",      "fov",     "anchor",  "pivot"};
+  constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+  std::vector<std::string> names;
+  for (size_t a = 0; a < kWordCount; ++a) {
+    names.emplace_back(kWords[a]);
+    for (size_t b = 0; b < kWordCount; ++b) {
+      std::string camel = std::string{kWords[a]} + kWords[b];
+      camel[std::char_traits<char>::length(kWords[a])] -= 'a' - 'A';
+      names.push_back(camel);
+      names.push_back(std::string{kWords[a]} + "_" + kWords[b]);
+      for (size_t c = 0; c < kWordCount; c += 3) {
+        names.push_back(std::string{"m_"} + kWords[a] + "_" + kWords[b] + "_" + kWords[c]);
+      }
+      for (int i = 0; i < 16; ++i) {
+        names.push_back(std::string{kWords[a]} + kWords[b] + std::to_string(i));
+      }
+    }
+  }
+  return names;
+}
+
+template <typename Hash> void report(const char* label, const std::vector<std::string>& names,
+                                     Hash hash) {
+  std::unordered_set<uint64_t> full;
+  std::unordered_set<uint32_t> low;
+  full.reserve(names.size());
+  low.reserve(names.size());
+  for (const auto& name : names) {
+    const uint64_t h = hash(name.data(), name.size());
+    full.insert(h);
+    low.insert(static_cast<uint32_t>(h));
+  }
+
+  constexpr int kRounds = 20;
+  uint64_t sink = 0;
+  size_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < kRounds; ++round) {
+    for (const auto& name : names) {
+      sink += hash(name.data(), name.size());
+      bytes += name.size();
+    }
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+  std::printf("%-10s collisions (64-bit): %zu  collisions (32-bit tag): %zu  %.2f ns/name  "
+              "%.2f GB/s  [%llx]\n",
+              label, names.size() - full.size(), names.size() - low.size(),
+              elapsed.count() / (names.size() * kRounds), bytes / elapsed.count(),
+              static_cast<unsigned long long>(sink & 0xff));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> names;
+  for (int i = 1; i < argc; ++i) {
+    std::ifstream in(argv[i]);
+    if (!in) {
+      std::fprintf(stderr, "Could not open %s\n", argv[i]);
+      return 1;
+    }
+    for (std::string line; std::getline(in, line);) {
+      if (!line.empty()) {
+        names.push_back(line);
+      }
+    }
+  }
+  if (names.empty()) {
+    names = syntheticCorpus();
+  }
+
+  // Only unique names count towards collisions.
+  std::unordered_set<std::string> unique(names.begin(), names.end());
+  names.assign(unique.begin(), unique.end());
+
+  std::printf("%zu unique names\n", names.size());
+  report("hashName", names, [](const char* name, size_t size) -> uint64_t {
+    return meta::detail::hashName(name, size);
+  });
+  report("fnv1a", names, fnv1a);
+
+  return 0;
+}
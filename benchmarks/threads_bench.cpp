@@ -0,0 +1,278 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Runs get/set of numeric, bool and (for contrast) stream converted properties on 1..N threads,
+// each thread working on its own object, and reports how the throughput scales.  Pass the maximum
+// number of threads as the first argument; it defaults to the number of hardware threads.
+//
+// Then sets one property on a million objects, one `set` at a time and with `bulkSet`, and
+// publishes sets from one thread through a `ChangeStream` that 1..N-1 consumer threads drain.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "meta/meta.h"
+#include "meta/meta_parallel.h"
+#include "meta/meta_stream.h"
+
+namespace {
+
+// A user type that only has stream operators, so it uses the stream based converter.
+struct Vec2 {
+  float x = 0.0f;
+  float y = 0.0f;
+};
+
+std::ostream& operator<<(std::ostream& os, const Vec2& value) {
+  return os << value.x << ' ' << value.y;
+}
+
+std::istream& operator>>(std::istream& is, Vec2& value) {
+  return is >> value.x >> value.y;
+}
+
+class BenchObj : public meta::MetaObject {
+  DECLARE_META_OBJECT(BenchObj);
+
+public:
+  int getCount() const {
+    return m_count;
+  }
+  void setCount(int count) {
+    m_count = count;
+  }
+
+  double getScale() const {
+    return m_scale;
+  }
+  void setScale(double scale) {
+    m_scale = scale;
+  }
+
+  bool isVisible() const {
+    return m_visible;
+  }
+  void setVisible(bool visible) {
+    m_visible = visible;
+  }
+
+  const Vec2& getPosition() const {
+    return m_position;
+  }
+  void setPosition(const Vec2& position) {
+    m_position = position;
+  }
+
+private:
+  int m_count = 0;
+  double m_scale = 1.0;
+  bool m_visible = false;
+  Vec2 m_position;
+};
+
+} // namespace
+
+DEFINE_META_OBJECT(BenchObj)
+    .addProperty<BenchObj, int>("count", "", meta::PropertyEditorType::Integer,
+                                &BenchObj::getCount, &BenchObj::setCount)
+    .addProperty<BenchObj, double>("scale", "", meta::PropertyEditorType::String,
+                                   &BenchObj::getScale, &BenchObj::setScale)
+    .addProperty<BenchObj, bool>("visible", "", meta::PropertyEditorType::Bool,
+                                 &BenchObj::isVisible, &BenchObj::setVisible)
+    .addProperty<BenchObj, Vec2>("position", "", meta::PropertyEditorType::String,
+                                 &BenchObj::getPosition, &BenchObj::setPosition);
+
+namespace {
+
+constexpr auto kDuration = std::chrono::milliseconds(300);
+
+// Returns the total number of get/set pairs per second over all threads.
+template <typename Func> double run(unsigned threadCount, Func func) {
+  std::atomic<bool> start{false};
+  std::atomic<bool> stop{false};
+  std::vector<uint64_t> counts(threadCount * 8, 0);
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < threadCount; ++t) {
+    threads.emplace_back([&, t]() {
+      BenchObj obj;
+      std::string value;
+      uint64_t count = 0;
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      while (!stop.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 64; ++i) {
+          func(obj, value);
+        }
+        count += 64;
+      }
+      // Spaced out to keep the counters on separate cache lines.
+      counts[t * 8] = count;
+    });
+  }
+
+  start.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(kDuration);
+  stop.store(true, std::memory_order_relaxed);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  uint64_t total = 0;
+  for (unsigned t = 0; t < threadCount; ++t) {
+    total += counts[t * 8];
+  }
+  return total / std::chrono::duration<double>(kDuration).count();
+}
+
+template <typename Func> void report(const char* label, unsigned maxThreads, Func func) {
+  std::printf("%s\n", label);
+  double single = 0.0;
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    const double throughput = run(threads, func);
+    if (threads == 1) {
+      single = throughput;
+    }
+    std::printf("  %3u threads %12.0f ops/s  scaling %5.2fx  efficiency %5.1f%%\n", threads,
+                throughput, throughput / single, 100.0 * throughput / (single * threads));
+  }
+}
+
+void reportBulkSet(unsigned maxThreads) {
+  constexpr size_t kObjectCount = 1'000'000;
+  std::vector<BenchObj> objects(kObjectCount);
+  std::vector<meta::MetaObject*> pointers;
+  for (BenchObj& obj : objects) {
+    pointers.push_back(&obj);
+  }
+
+  const auto time = [](auto func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+  };
+
+  std::printf("bulk set of %zu objects\n", kObjectCount);
+  std::printf("  set per object     %8.2f ms\n", time([&]() {
+                for (meta::MetaObject* obj : pointers) {
+                  obj->set("scale", "1.25");
+                }
+              }));
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    meta::ThreadPool pool(threads);
+    std::printf("  bulkSet %3u threads %8.2f ms\n", threads,
+                time([&]() { meta::bulkSet(&pool, pointers, "scale", "1.25"); }));
+  }
+}
+
+void reportStream(unsigned maxConsumers, meta::PropertyHandle count) {
+  std::printf("change stream\n");
+  for (unsigned consumers = 1; consumers <= maxConsumers; consumers *= 2) {
+    meta::ChangeStream stream(4096);
+    BenchObj obj;
+    stream.watch(&obj);
+
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> received(consumers * 8, 0);
+    std::vector<uint64_t> dropped(consumers * 8, 0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < consumers; ++t) {
+      threads.emplace_back([&, t]() {
+        meta::ChangeStream::Consumer consumer(stream);
+        meta::ChangeRecord record;
+        uint64_t count = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+          while (consumer.poll(&record)) {
+            ++count;
+          }
+          std::this_thread::yield();
+        }
+        received[t * 8] = count;
+        dropped[t * 8] = consumer.getDropped();
+      });
+    }
+
+    uint64_t published = 0;
+    const auto end = std::chrono::steady_clock::now() + kDuration;
+    while (std::chrono::steady_clock::now() < end) {
+      for (int i = 0; i < 64; ++i) {
+        obj.set(count, static_cast<int>(published++));
+      }
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    uint64_t totalReceived = 0;
+    uint64_t totalDropped = 0;
+    for (unsigned t = 0; t < consumers; ++t) {
+      totalReceived += received[t * 8];
+      totalDropped += dropped[t * 8];
+    }
+    const double seconds = std::chrono::duration<double>(kDuration).count();
+    std::printf("  %3u consumers %12.0f sets/s  %12.0f reads/s per consumer  %5.1f%% dropped\n",
+                consumers, published / seconds, totalReceived / consumers / seconds,
+                100.0 * totalDropped / (published * consumers));
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  unsigned maxThreads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1]))
+                                 : std::max(1u, std::thread::hardware_concurrency());
+
+  const meta::MetaBuilder* builder = BenchObj::GetStaticMetaBuilder();
+  const meta::PropertyHandle count = builder->resolve("count");
+  const meta::PropertyHandle scale = builder->resolve("scale");
+  const meta::PropertyHandle visible = builder->resolve("visible");
+  const meta::PropertyHandle position = builder->resolve("position");
+
+  report("int", maxThreads, [&](BenchObj& obj, std::string& value) {
+    obj.set(count, "12345");
+    obj.get(count, &value);
+  });
+  report("double", maxThreads, [&](BenchObj& obj, std::string& value) {
+    obj.set(scale, "1.25");
+    obj.get(scale, &value);
+  });
+  report("bool", maxThreads, [&](BenchObj& obj, std::string& value) {
+    obj.set(visible, "true");
+    obj.get(visible, &value);
+  });
+  report("stream (user type)", maxThreads, [&](BenchObj& obj, std::string& value) {
+    obj.set(position, "1.5 2.5");
+    obj.get(position, &value);
+  });
+
+  reportBulkSet(maxThreads);
+  reportStream(std::max(1u, maxThreads - 1), count);
+
+  return 0;
+}
@@ -21,13 +21,21 @@
 #ifndef META_H_
 #define META_H_
 
+#include <any>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <set>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -36,16 +44,61 @@
 namespace meta {
 
 class MetaBuilder;
+class MetaObject;
 
 namespace detail {
 
+// Read bytes as little endian words.  These are written byte by byte so that they can be used in
+// constant expressions; optimizing compilers turn each of them into a single load.
+constexpr inline uint64_t readByte(const char* data) {
+  return static_cast<uint64_t>(static_cast<unsigned char>(*data));
+}
+
+constexpr inline uint64_t readWord32(const char* data) {
+  return readByte(data) | readByte(data + 1) << 8 | readByte(data + 2) << 16 |
+         readByte(data + 3) << 24;
+}
+
+constexpr inline uint64_t readWord64(const char* data) {
+  return readWord32(data) | readWord32(data + 4) << 32;
+}
+
+constexpr inline uint64_t mixWord(uint64_t hash, uint64_t word) {
+  hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+  return hash ^ (hash >> 29);
+}
+
+// Hash a property name 8 bytes at a time.  Exactly `size` bytes are hashed, embedded NUL
+// characters included.  Hashes are only used to find a candidate; names are always compared in
+// full before a lookup succeeds.
 constexpr inline size_t hashName(const char* name, size_t size) {
-  size_t hash = 0x811c9dc5, i = 0;
-  while (*name && i < size) {
-    hash = hash ^ (size_t)(*name++);
-    hash = hash * 16777619;
+  // The size is part of the seed, which makes it safe for the reads of the tail below to overlap
+  // bytes that were already hashed.
+  uint64_t hash = 0x9e3779b97f4a7c15ull ^ (static_cast<uint64_t>(size) * 0xc2b2ae3d27d4eb4full);
+
+  if (size >= 8) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+      hash = mixWord(hash, readWord64(name + i));
+    }
+    if (i < size) {
+      hash = mixWord(hash, readWord64(name + size - 8));
+    }
+  } else if (size >= 4) {
+    hash = mixWord(hash, readWord32(name) | readWord32(name + size - 4) << 32);
+  } else if (size > 0) {
+    hash = mixWord(hash, readByte(name) | readByte(name + size / 2) << 8 |
+                             readByte(name + size - 1) << 16);
   }
-  return hash;
+
+  // Final avalanche, so that every input bit affects the low bits we use as slot tags.
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  hash ^= hash >> 33;
+
+  return static_cast<size_t>(hash);
 }
 
 constexpr inline size_t hashName(const std::string_view name) {
@@ -54,36 +107,381 @@ constexpr inline size_t hashName(const std::string_view name) {
 
 } // namespace detail
 
+// Make sure a builder defined at compile time is constant initialized.  Without this, some
+// compilers fall back to dynamic initialization for class types with a non-trivial destructor.
+#if defined(__cpp_constinit)
+#define META_CONSTINIT constinit
+#elif defined(__clang__)
+#define META_CONSTINIT [[clang::require_constant_initialization]]
+#elif defined(__GNUC__) && __GNUC__ >= 10
+#define META_CONSTINIT __constinit
+#else
+#define META_CONSTINIT
+#endif
+
+#if defined(__cpp_consteval)
+#define META_CONSTEVAL consteval
+#else
+#define META_CONSTEVAL constexpr
+#endif
+
+// A property name along with its hash.  Lookups with a `PropertyName` skip hashing the name.  The
+// `_prop` literal computes the hash at compile time (from C++20, or when used to initialize a
+// `constexpr` variable), e.g.:
+//
+//   using namespace meta::literals;
+//   obj.get("count"_prop, &value);
+struct PropertyName {
+  constexpr explicit PropertyName(std::string_view name)
+      : name(name), hash(detail::hashName(name)) {}
+
+  std::string_view name;
+  size_t hash;
+};
+
+namespace literals {
+
+META_CONSTEVAL inline PropertyName operator""_prop(const char* name, size_t size) {
+  return PropertyName{std::string_view{name, size}};
+}
+
+} // namespace literals
+
+// Receives the characters of a converted value.  An `AppendSink` wraps a pointer to any object with
+// an `append(const char*, size_t)` member, such as `std::string`, so that many values can be
+// written into one output without an intermediate string per value.  The sink does not own the
+// target, which must outlive it.
+class AppendSink {
+public:
+  template <typename Target>
+  explicit AppendSink(Target* target)
+      : m_target(target), m_append([](void* t, const char* data, size_t size) {
+          static_cast<Target*>(t)->append(data, size);
+        }) {}
+
+  void append(const char* data, size_t size) {
+    m_append(m_target, data, size);
+  }
+
+private:
+  void* m_target;
+  void (*m_append)(void*, const char*, size_t);
+};
+
+namespace detail {
+
+// Writes into a fixed size buffer.  Keeps counting when the buffer is full, so that the caller can
+// find out how large the buffer should have been.
+struct BufferWriter {
+  char* buffer;
+  size_t capacity;
+  size_t length = 0;
+
+  void append(const char* data, size_t size) {
+    if (length + size <= capacity) {
+      std::memcpy(buffer + length, data, size);
+    }
+    length += size;
+  }
+};
+
+template <typename Converter, typename T, typename = void>
+struct HasWrite : std::false_type {};
+
+template <typename Converter, typename T>
+struct HasWrite<Converter, T,
+                std::void_t<decltype(Converter::Write(std::declval<const T&>(),
+                                                      std::declval<AppendSink*>()))>>
+    : std::true_type {};
+
+template <typename T, typename = void> struct IsEqualityComparable : std::false_type {};
+
+template <typename T>
+struct IsEqualityComparable<T, std::void_t<decltype(std::declval<const T&>() ==
+                                                    std::declval<const T&>())>> : std::true_type {};
+
+template <typename Converter, typename T, typename = void>
+struct HasStringViewFromString : std::false_type {};
+
+template <typename Converter, typename T>
+struct HasStringViewFromString<
+    Converter, T,
+    std::void_t<decltype(Converter::FromString(std::declval<std::string_view>(),
+                                               std::declval<T*>()))>> : std::true_type {};
+
+// Read a value from a string.  Converters that only accept a `const std::string&` get a copy.
+template <typename T> bool readValue(std::string_view value, T* outValue) {
+  using Converter = MetaConverter<T>;
+  if constexpr (HasStringViewFromString<Converter, T>::value) {
+    return Converter::FromString(value, outValue);
+  } else {
+    return Converter::FromString(std::string{value}, outValue);
+  }
+}
+
+// Write a value to a sink.  Converters that don't know how to write to a sink directly go through
+// a temporary string.
+template <typename T> bool writeValue(const T& value, AppendSink* sink) {
+  using Converter = MetaConverter<T>;
+  if constexpr (HasWrite<Converter, T>::value) {
+    return Converter::Write(value, sink);
+  } else {
+    std::string str;
+    if (!Converter::ToString(value, &str)) {
+      return false;
+    }
+    sink->append(str.data(), str.size());
+    return true;
+  }
+}
+
+} // namespace detail
+
+namespace detail {
+
+template <typename T>
+using EnableIfNotString = std::enable_if_t<!std::is_convertible_v<const T&, std::string_view>>;
+
+} // namespace detail
+
+// A property resolved by a `MetaBuilder`.  A handle stays valid for as long as the builder that
+// resolved it and can only be used with objects of that builder.  A default constructed handle
+// does not refer to any property.
+struct PropertyHandle {
+  const MetaBuilder* builder = nullptr;
+  uint32_t index = 0;
+
+  explicit operator bool() const {
+    return builder != nullptr;
+  }
+};
+
+// Receives the changes made to the properties of the objects it is added to.
+class ChangeListener {
+public:
+  virtual ~ChangeListener();
+
+  // Called after a property of `obj` was set successfully.  Must not add or remove listeners of
+  // `obj`.
+  virtual void propertyChanged(MetaObject* obj, PropertyHandle handle) = 0;
+
+  // Called when `obj` is destroyed, after which the listener is no longer referenced.  Listeners
+  // that keep `obj` around must drop it here, so there is no default.
+  virtual void objectDestroyed(MetaObject* obj) = 0;
+};
+
+namespace detail {
+
+inline unsigned countTrailingZeros(uint64_t word) {
+  assert(word);
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+  unsigned count = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+// State of an object that is only allocated once the object uses change tracking.
+struct ObjectState {
+  // One bit per property index, set when the property changes.
+  std::vector<uint64_t> dirty;
+  std::vector<ChangeListener*> listeners;
+};
+
+// Owns the state of an object.  The state describes the object it belongs to, so a copied or
+// moved object starts without any and assigning to an object keeps its own.
+class ObjectStatePtr {
+public:
+  ObjectStatePtr() = default;
+  ObjectStatePtr(const ObjectStatePtr&) {}
+
+  ObjectStatePtr& operator=(const ObjectStatePtr&) {
+    return *this;
+  }
+
+  ObjectState* get() const {
+    return m_state.get();
+  }
+
+  ObjectState& getOrCreate() {
+    if (!m_state) {
+      m_state = std::make_unique<ObjectState>();
+    }
+    return *m_state;
+  }
+
+private:
+  std::unique_ptr<ObjectState> m_state;
+};
+
+} // namespace detail
+
 class MetaObject {
 public:
   virtual ~MetaObject();
 
   virtual bool get(std::string_view name, std::string* outValue) = 0;
-  virtual bool set(std::string_view name, const std::string& value) = 0;
+  virtual bool set(std::string_view name, std::string_view value) = 0;
   virtual const MetaBuilder* getMetaBuilder() const = 0;
+
+  // Get and set a property without looking up its name.  The handle must be resolved by the
+  // builder returned from `getMetaBuilder()`.
+  bool get(PropertyHandle handle, std::string* outValue);
+  bool set(PropertyHandle handle, std::string_view value);
+
+  // Get and set a property with a name that was hashed up front.
+  bool get(const PropertyName& name, std::string* outValue);
+  bool set(const PropertyName& name, std::string_view value);
+
+  // Append the value of a property to a sink.
+  bool get(PropertyHandle handle, AppendSink sink);
+  bool get(const PropertyName& name, AppendSink sink);
+  bool get(std::string_view name, AppendSink sink);
+
+  // Write the value of a property into a buffer, which is not NUL terminated.  `outLength` receives
+  // the length of the value, even if it did not fit into the buffer, in which case false is
+  // returned.
+  bool get(PropertyHandle handle, char* buffer, size_t bufferSize, size_t* outLength);
+  bool get(const PropertyName& name, char* buffer, size_t bufferSize, size_t* outLength);
+  bool get(std::string_view name, char* buffer, size_t bufferSize, size_t* outLength);
+
+  // Get and set a property as its own type, without converting it to or from a string.  `T` must
+  // be exactly the type the property was registered with, otherwise false is returned.  Values
+  // that convert to a `std::string_view` always use the string overloads above.
+  template <typename T> bool get(PropertyHandle handle, T* outValue);
+  template <typename T> bool get(const PropertyName& name, T* outValue);
+  template <typename T> bool get(std::string_view name, T* outValue);
+
+  template <typename T, typename = detail::EnableIfNotString<T>>
+  bool set(PropertyHandle handle, const T& value);
+  template <typename T, typename = detail::EnableIfNotString<T>>
+  bool set(const PropertyName& name, const T& value);
+  template <typename T, typename = detail::EnableIfNotString<T>>
+  bool set(std::string_view name, const T& value);
+
+  // Record which properties change through `set`.  Tracking stays on for the life of the object
+  // and costs nothing for objects that never enable it.  Changes made by calling the setters of
+  // the class directly are not seen.
+  void enableDirtyTracking();
+
+  bool isDirtyTrackingEnabled() const {
+    const detail::ObjectState* state = m_state.get();
+    return state && !state->dirty.empty();
+  }
+
+  bool isDirty(PropertyHandle handle) const;
+
+  // Call `func(PropertyHandle)` for every property that changed since the last `clearDirty`, in
+  // property index order.
+  template <typename Func> void forEachDirty(Func&& func) const;
+
+  void clearDirty();
+
+  // Listeners are told about every successful `set` on this object.  The object does not own them;
+  // a listener must be removed before it is destroyed.
+  void addChangeListener(ChangeListener* listener);
+  void removeChangeListener(ChangeListener* listener);
+
+  // Whether anything needs to hear about changes to this object.
+  bool isObserved() const {
+    return m_state.get() != nullptr;
+  }
+
+  // Report a change that was made without `set`, for example by calling a setter of the class, to
+  // dirty tracking and listeners.
+  void markChanged(PropertyHandle handle) {
+    assert(handle.builder == getMetaBuilder());
+    changed(handle);
+  }
+
+private:
+  // Called after a property was set successfully.
+  void changed(PropertyHandle handle) {
+    if (m_state.get()) {
+      notifyChanged(handle);
+    }
+  }
+
+  void notifyChanged(PropertyHandle handle);
+
+  detail::ObjectStatePtr m_state;
 };
 
+struct PropertyBase;
+
+// The functions that operate on a property.  There is one table for every combination of class and
+// property type, shared by all the properties of that combination.
+struct PropertyOps {
+  // The type the property was registered with.
+  detail::TypeId type;
+
+  bool (*get)(const PropertyBase*, MetaObject*, std::string*);
+  bool (*write)(const PropertyBase*, MetaObject*, AppendSink*);
+  bool (*set)(const PropertyBase*, MetaObject*, std::string_view);
+  bool (*isReadOnly)(const PropertyBase*);
+
+  // Get and set the value as its own type; the `void*` points to a value of `type`.
+  bool (*getTyped)(const PropertyBase*, MetaObject*, void*);
+  bool (*setTyped)(const PropertyBase*, MetaObject*, const void*);
+
+  // Get the value of `count` objects into an array of `type`.
+  void (*getTypedBatch)(const PropertyBase*, MetaObject* const*, size_t, void*);
+
+  // Convert text to a value of `type` once, and set that value on `count` objects.
+  bool (*parse)(std::string_view, std::any*);
+  bool (*setTypedBatch)(const PropertyBase*, MetaObject* const*, size_t, const std::any&);
+
+  // Whether two objects hold the same value, compared with `operator==` when the type has one and
+  // as text otherwise.
+  bool (*equals)(const PropertyBase*, MetaObject*, MetaObject*);
+
+  const PropertyBase* (*clone)(const PropertyBase*, detail::Arena*);
+};
+
+// Type erased property.  Calls are forwarded through the operations table, so reaching the getter
+// or setter of a property costs a single indirect call.
 struct PropertyBase {
-  // Generic pointer type we use to store function pointers that can be cast
-  // back to their original type before use.
-  using FuncStorage = void (*)();
+  bool get(MetaObject* obj, std::string* outValue) const {
+    return ops->get(this, obj, outValue);
+  }
 
-  virtual ~PropertyBase();
+  bool write(MetaObject* obj, AppendSink* sink) const {
+    return ops->write(this, obj, sink);
+  }
 
-  virtual bool get(MetaObject*, std::string*) {
-    return false;
+  bool set(MetaObject* obj, std::string_view value) const {
+    return ops->set(this, obj, value);
   }
 
-  virtual bool set(MetaObject*, const std::string&) {
-    return false;
+  bool isReadOnly() const {
+    return ops->isReadOnly(this);
   }
 
-  virtual bool isReadOnly() const {
-    return false;
+  bool equals(MetaObject* obj, MetaObject* other) const {
+    return ops->equals(this, obj, other);
+  }
+
+  template <typename T> bool hasType() const {
+    return ops->type == detail::typeId<T>();
+  }
+
+  // Get and set the value without converting it to or from a string.  Fails if `T` is not exactly
+  // the type the property was registered with.
+  template <typename T> bool getTyped(MetaObject* obj, T* outValue) const {
+    assert(outValue);
+    return hasType<T>() && ops->getTyped(this, obj, outValue);
+  }
+
+  template <typename T> bool setTyped(MetaObject* obj, const T& value) const {
+    return hasType<T>() && ops->setTyped(this, obj, &value);
   }
 
-  FuncStorage invokerGet;
-  FuncStorage invokerSet;
+  const PropertyOps* ops;
 };
 
 // Interface to invoke the get and set functions of a property for a given
@@ -92,33 +490,110 @@ template <typename PropertyType> struct Invoker {
   using ClassType = typename PropertyType::ClassType;
   using Type = typename PropertyType::Type;
 
-  using SetType = bool (*)(PropertyBase*, ClassType*, const std::string&);
-  using GetType = bool (*)(PropertyBase*, ClassType*, std::string*);
-
-  static bool get(PropertyBase* p, ClassType* obj, std::string* outValue) {
-    auto* prop = static_cast<PropertyType*>(p);
+  static bool get(const PropertyBase* p, MetaObject* obj, std::string* outValue) {
+    auto* prop = static_cast<const PropertyType*>(p);
 
     // No need to check if a getter is set to nullptr, because our system
     // doesn't allow a nullptr getter.
 
-    Type x((obj->*(prop->getter))());
+    Type x((static_cast<ClassType*>(obj)->*(prop->getter))());
     return detail::MetaConverter<Type>::ToString(x, outValue);
   }
 
-  static bool set(PropertyBase* p, ClassType* obj, const std::string& value) {
-    auto* prop = static_cast<PropertyType*>(p);
+  static bool write(const PropertyBase* p, MetaObject* obj, AppendSink* sink) {
+    auto* prop = static_cast<const PropertyType*>(p);
+    return detail::writeValue<Type>((static_cast<ClassType*>(obj)->*(prop->getter))(), sink);
+  }
+
+  static bool set(const PropertyBase* p, MetaObject* obj, std::string_view value) {
+    auto* prop = static_cast<const PropertyType*>(p);
     if (!prop->setter) {
       return false;
     }
 
     Type x;
-    if (detail::MetaConverter<Type>::FromString(value, &x)) {
-      (obj->*(prop->setter))(x);
+    if (detail::readValue<Type>(value, &x)) {
+      (static_cast<ClassType*>(obj)->*(prop->setter))(x);
       return true;
     }
 
     return false;
   }
+
+  static bool isReadOnly(const PropertyBase* p) {
+    return !static_cast<const PropertyType*>(p)->setter;
+  }
+
+  static bool getTyped(const PropertyBase* p, MetaObject* obj, void* outValue) {
+    auto* prop = static_cast<const PropertyType*>(p);
+    *static_cast<Type*>(outValue) = (static_cast<ClassType*>(obj)->*(prop->getter))();
+    return true;
+  }
+
+  static void getTypedBatch(const PropertyBase* p, MetaObject* const* objects, size_t count,
+                            void* outValues) {
+    auto* prop = static_cast<const PropertyType*>(p);
+    const auto getter = prop->getter;
+    auto* values = static_cast<Type*>(outValues);
+    for (size_t i = 0; i < count; ++i) {
+      values[i] = (static_cast<ClassType*>(objects[i])->*getter)();
+    }
+  }
+
+  static bool parse(std::string_view text, std::any* outValue) {
+    Type x;
+    if (!detail::readValue<Type>(text, &x)) {
+      return false;
+    }
+    *outValue = std::move(x);
+    return true;
+  }
+
+  static bool setTypedBatch(const PropertyBase* p, MetaObject* const* objects, size_t count,
+                            const std::any& value) {
+    auto* prop = static_cast<const PropertyType*>(p);
+    const auto* x = std::any_cast<Type>(&value);
+    if (!prop->setter || !x) {
+      return false;
+    }
+    const auto setter = prop->setter;
+    for (size_t i = 0; i < count; ++i) {
+      (static_cast<ClassType*>(objects[i])->*setter)(*x);
+    }
+    return true;
+  }
+
+  static bool setTyped(const PropertyBase* p, MetaObject* obj, const void* value) {
+    auto* prop = static_cast<const PropertyType*>(p);
+    if (!prop->setter) {
+      return false;
+    }
+    (static_cast<ClassType*>(obj)->*(prop->setter))(*static_cast<const Type*>(value));
+    return true;
+  }
+
+  static bool equals(const PropertyBase* p, MetaObject* obj, MetaObject* other) {
+    auto* prop = static_cast<const PropertyType*>(p);
+    const auto& x = (static_cast<ClassType*>(obj)->*(prop->getter))();
+    const auto& y = (static_cast<ClassType*>(other)->*(prop->getter))();
+    if constexpr (detail::IsEqualityComparable<Type>::value) {
+      return static_cast<bool>(x == y);
+    } else {
+      std::string xText;
+      std::string yText;
+      return detail::MetaConverter<Type>::ToString(x, &xText) &&
+             detail::MetaConverter<Type>::ToString(y, &yText) && xText == yText;
+    }
+  }
+
+  static const PropertyBase* clone(const PropertyBase* p, detail::Arena* arena) {
+    void* memory = arena->allocate(sizeof(PropertyType), alignof(PropertyType));
+    return new (memory) PropertyType(*static_cast<const PropertyType*>(p));
+  }
+
+  static constexpr PropertyOps ops = {detail::typeId<Type>(), &get, &write, &set, &isReadOnly,
+                                      &getTyped, &setTyped, &getTypedBatch, &parse,
+                                      &setTypedBatch, &equals, &clone};
 };
 
 // A property typed on it's class type and property type.
@@ -133,29 +608,9 @@ struct Property : public PropertyBase {
   using SetterType = typename detail::MetaPropertyTraits<C, T>::SetterType;
 
   using InvokerType = Invoker<Property<ClassType, Type>>;
-  using InvokerGetType = typename InvokerType::GetType;
-  using InvokerSetType = typename InvokerType::SetType;
 
-  Property(GetterType getter, SetterType setter) : getter(getter), setter(setter) {
-    invokerGet = reinterpret_cast<FuncStorage>(&InvokerType::get);
-    invokerSet = reinterpret_cast<FuncStorage>(&InvokerType::set);
-  }
-
-  ~Property() override = default;
-
-  bool get(MetaObject* obj, std::string* outValue) override {
-    auto func = reinterpret_cast<InvokerGetType>(invokerGet);
-    return func(this, static_cast<ClassType*>(obj), outValue);
-  }
-
-  bool set(MetaObject* obj, const std::string& value) override {
-    auto func = reinterpret_cast<InvokerSetType>(invokerSet);
-    return func(this, static_cast<ClassType*>(obj), value);
-  }
-
-  bool isReadOnly() const override {
-    return !setter;
-  }
+  constexpr Property(GetterType getter, SetterType setter)
+      : PropertyBase{&InvokerType::ops}, getter(getter), setter(setter) {}
 
   GetterType getter;
   SetterType setter;
@@ -167,84 +622,742 @@ enum class PropertyEditorType {
   Bool,
 };
 
+// The strings and property of an entry are owned by the `MetaBuilder` that created it.
 struct MetaEntry {
 public:
-  std::string name;
-  std::string description;
+  std::string_view name;
+  std::string_view description;
   PropertyEditorType editorType;
-  std::shared_ptr<PropertyBase> prop;
+  const PropertyBase* prop;
+
+  constexpr MetaEntry(std::string_view name, std::string_view description,
+                      PropertyEditorType editorType, const PropertyBase* prop)
+      : name(name), description(description), editorType(editorType), prop(prop) {}
+};
+
+namespace detail {
 
-  MetaEntry(std::string name, std::string description, PropertyEditorType editorType,
-            std::shared_ptr<PropertyBase> prop)
-      : name(std::move(name)), description(std::move(description)), editorType(editorType),
-        prop(std::move(prop)) {}
+// A single slot in a perfect hash table.  The tag holds the low bits of the name hash so that
+// misses can be rejected without touching the entry itself.
+struct LookupSlot {
+  static constexpr uint32_t kEmpty = ~uint32_t(0);
+
+  uint32_t tag = 0;
+  uint32_t index = kEmpty;
+};
+
+// Lookup tables are built with hash and displace: a name hashes to one of a small number of
+// buckets, and every bucket holds the displacement that moves all of its names into free slots.
+// Placing the largest buckets first keeps the table about 1.5 slots per name and the build linear.
+constexpr size_t kLookupBucketSize = 4;
+
+// Number of displacements we try for a bucket before growing the table.
+constexpr uint32_t kLookupDisplacementAttempts = 1 << 16;
+
+// splitmix64 finalizer.
+constexpr inline uint64_t lookupMix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+constexpr inline size_t lookupBucketIndex(size_t hash, unsigned bucketShift) {
+  return static_cast<size_t>((static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ull) >> bucketShift);
+}
+
+constexpr inline size_t lookupSlotIndex(size_t hash, uint32_t displacement, unsigned shift) {
+  return static_cast<size_t>(
+      lookupMix(static_cast<uint64_t>(hash) ^ (displacement * 0x9e3779b97f4a7c15ull)) >> shift);
+}
+
+// The smallest number of bits for a table at most two thirds full.
+constexpr inline unsigned lookupTableBits(size_t count) {
+  unsigned bits = 1;
+  while ((size_t(1) << bits) < count + count / 2) {
+    ++bits;
+  }
+  return bits;
+}
+
+constexpr inline unsigned lookupBucketBits(size_t count) {
+  unsigned bits = 1;
+  while ((size_t(1) << bits) * kLookupBucketSize < count) {
+    ++bits;
+  }
+  return bits;
+}
+
+// Place `count` hashes into `slots` (`1 << slotBits` empty slots) and fill `displacements`
+// (`1 << bucketBits` entries).  The index of a slot is the position of its hash in `hashes`.
+// `bucketStart` (one more than the number of buckets) and `order` (`count`) are scratch space, so
+// that this can run in constant expressions.  Returns false if two hashes are equal or a bucket
+// could not be placed, in which case a larger table may succeed.
+constexpr inline bool placeLookupKeys(const size_t* hashes, size_t count, unsigned slotBits,
+                                      unsigned bucketBits, uint32_t* displacements,
+                                      LookupSlot* slots, uint32_t* bucketStart, uint32_t* order) {
+  const size_t bucketCount = size_t(1) << bucketBits;
+  const unsigned bucketShift = 64 - bucketBits;
+  const unsigned shift = 64 - slotBits;
+
+  // Sort the hashes by bucket.
+  for (size_t b = 0; b <= bucketCount; ++b) {
+    bucketStart[b] = 0;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    ++bucketStart[lookupBucketIndex(hashes[i], bucketShift) + 1];
+  }
+  size_t largest = 0;
+  for (size_t b = 0; b < bucketCount; ++b) {
+    largest = bucketStart[b + 1] > largest ? bucketStart[b + 1] : largest;
+    bucketStart[b + 1] += bucketStart[b];
+  }
+  for (size_t i = 0; i < count; ++i) {
+    order[bucketStart[lookupBucketIndex(hashes[i], bucketShift)]++] = static_cast<uint32_t>(i);
+  }
+  for (size_t b = bucketCount; b > 0; --b) {
+    bucketStart[b] = bucketStart[b - 1];
+  }
+  bucketStart[0] = 0;
+
+  for (size_t size = largest; size > 0; --size) {
+    for (size_t b = 0; b < bucketCount; ++b) {
+      const uint32_t begin = bucketStart[b];
+      const uint32_t end = bucketStart[b + 1];
+      if (end - begin != size) {
+        continue;
+      }
+      for (uint32_t i = begin; i < end; ++i) {
+        for (uint32_t j = i + 1; j < end; ++j) {
+          if (hashes[order[i]] == hashes[order[j]]) {
+            return false;
+          }
+        }
+      }
+
+      uint32_t displacement = 0;
+      for (; displacement < kLookupDisplacementAttempts; ++displacement) {
+        uint32_t placed = begin;
+        for (; placed < end; ++placed) {
+          LookupSlot& slot = slots[lookupSlotIndex(hashes[order[placed]], displacement, shift)];
+          if (slot.index != LookupSlot::kEmpty) {
+            break;
+          }
+          slot.tag = static_cast<uint32_t>(hashes[order[placed]]);
+          slot.index = order[placed];
+        }
+        if (placed == end) {
+          break;
+        }
+        for (uint32_t i = begin; i < placed; ++i) {
+          slots[lookupSlotIndex(hashes[order[i]], displacement, shift)] = LookupSlot{};
+        }
+      }
+      if (displacement == kLookupDisplacementAttempts) {
+        return false;
+      }
+      displacements[b] = displacement;
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
+// Property tables generated at compile time, see `DEFINE_STATIC_META_OBJECT`.  When `frozen` is
+// false, the lookup table is built on first use (after the bases are known to be initialized).
+// The size and flag are spelled out rather than derived from `table`, because comparing the
+// address of a constexpr array with null is not a constant expression under some sanitizers.
+struct StaticSchema {
+  const MetaEntry* entries;
+  size_t entryCount;
+  const MetaBuilder* const* bases;
+  size_t baseCount;
+
+  const MetaEntry* const* table;
+  size_t tableSize;
+  const detail::LookupSlot* slots;
+  const uint32_t* displacements;
+  unsigned bucketShift;
+  unsigned shift;
+  bool frozen;
+};
+
+// The text of every property of an object, taken with `MetaBuilder::snapshot`.  All values live in
+// one buffer that starts with an index of their offsets, so taking a snapshot into an existing
+// `Snapshot` reuses its memory.
+class Snapshot {
+public:
+  const MetaBuilder* getMetaBuilder() const {
+    return m_builder;
+  }
+
+  // Number of values; one for every property of the builder.
+  size_t size() const {
+    return m_count;
+  }
+
+  std::string_view getValue(size_t index) const {
+    assert(index < m_count);
+    const uint32_t begin = getOffset(index);
+    const uint32_t end = getOffset(index + 1);
+    return std::string_view{m_buffer.data() + getHeaderSize() + begin, end - begin};
+  }
+
+  std::string_view getValue(PropertyHandle handle) const {
+    assert(handle.builder == m_builder);
+    return getValue(handle.index);
+  }
+
+private:
+  friend class MetaBuilder;
+
+  size_t getHeaderSize() const {
+    return (m_count + 1) * sizeof(uint32_t);
+  }
+
+  uint32_t getOffset(size_t index) const {
+    uint32_t offset;
+    std::memcpy(&offset, m_buffer.data() + index * sizeof(uint32_t), sizeof(offset));
+    return offset;
+  }
+
+  const MetaBuilder* m_builder = nullptr;
+  size_t m_count = 0;
+  // `m_count + 1` offsets relative to the end of the index, followed by the values.
+  std::string m_buffer;
+};
+
+// The writable properties that differ between two objects, with their values, taken with
+// `MetaBuilder::diff`.  Applying a patch to an object makes those properties match.
+class Patch {
+public:
+  const MetaBuilder* getMetaBuilder() const {
+    return m_builder;
+  }
+
+  // Number of properties that differ.
+  size_t size() const {
+    return m_entries.size();
+  }
+
+  bool empty() const {
+    return m_entries.empty();
+  }
+
+  PropertyHandle getHandle(size_t index) const {
+    assert(index < m_entries.size());
+    return PropertyHandle{m_builder, m_entries[index].property};
+  }
+
+  std::string_view getValue(size_t index) const {
+    assert(index < m_entries.size());
+    const uint32_t begin = index ? m_entries[index - 1].end : 0;
+    return std::string_view{m_values.data() + begin, m_entries[index].end - begin};
+  }
+
+private:
+  friend class MetaBuilder;
+
+  struct Entry {
+    uint32_t property;
+    // End of the value in `m_values`; it starts where the previous one ends.
+    uint32_t end;
+  };
+
+  const MetaBuilder* m_builder = nullptr;
+  std::vector<Entry> m_entries;
+  std::string m_values;
 };
 
 // Utility class to build properties for a specified class.
+//
+// A builder is filled in once (usually by `DEFINE_META_OBJECT`) and then frozen.  Freezing merges
+// the properties of the builder and all of its bases into a single table and turns that into a
+// collision free (perfect) hash table stored in a contiguous array, so a lookup by name costs one
+// hash and one probe, no matter how deep the inheritance hierarchy is.
+//
+// Shadowing rules for the merged table:
+//  - A property defined by the builder itself shadows an inherited property with the same name.
+//  - If more than one base defines a name, the base that was added first wins.
+//  - If a builder defines a name more than once, the first definition wins.
+//
+// Freezing happens automatically on the first lookup, but can be triggered up front by calling
+// `freeze()`.  No properties can be added once the builder is frozen.
+//
+// The properties and their names are stored next to each other in an arena owned by the builder.
+// Builders created from a `StaticSchema` own nothing and are constant initialized.
 class MetaBuilder {
 public:
-  using PropertiesType = std::unordered_map<size_t, MetaEntry>;
+  using PropertiesType = std::vector<MetaEntry>;
   using BasesType = std::vector<const MetaBuilder*>;
 
-  MetaBuilder& addBase(const MetaBuilder* metaBuilder) {
-    m_bases.push_back(metaBuilder);
+  MetaBuilder() = default;
+
+  constexpr explicit MetaBuilder(const StaticSchema& schema)
+      : m_entries(schema.entries), m_entryCount(schema.entryCount), m_bases(schema.bases),
+        m_baseCount(schema.baseCount), m_table(schema.table),
+        m_tableSize(schema.tableSize), m_slots(schema.slots),
+        m_displacements(schema.displacements), m_bucketShift(schema.bucketShift),
+        m_shift(schema.shift), m_frozen(schema.frozen) {}
+
+  // Copies only the definition of the builder; the copy is frozen on its own.
+  MetaBuilder(const MetaBuilder& other);
+
+  // Takes over the storage of `other`, which is left empty.
+  MetaBuilder(MetaBuilder&& other) noexcept;
+
+  // The `&&` overloads keep a chain on a temporary builder (as in `DEFINE_META_OBJECT`) an rvalue,
+  // so the builder it initializes takes over its storage instead of copying every property.
+  MetaBuilder& addBase(const MetaBuilder* metaBuilder) & {
+    assert(!isFrozen());
+    Storage& storage = getStorage();
+    storage.bases.push_back(metaBuilder);
+    m_bases = storage.bases.data();
+    m_baseCount = storage.bases.size();
     return *this;
   }
 
+  MetaBuilder&& addBase(const MetaBuilder* metaBuilder) && {
+    return std::move(addBase(metaBuilder));
+  }
+
   template <typename C, typename T>
   MetaBuilder& addProperty(std::string_view name, std::string_view description,
                            PropertyEditorType editorType,
-                           typename detail::MetaPropertyTraits<C, T>::GetterType getter) {
-    m_properties.insert(PropertiesType::value_type(
-        detail::hashName(name),
-        MetaEntry({name.begin(), name.end()}, {description.begin(), description.end()}, editorType,
-                  std::make_shared<Property<C, T>>(getter, nullptr))));
-    return *this;
+                           typename detail::MetaPropertyTraits<C, T>::GetterType getter) & {
+    return addEntry<C, T>(name, description, editorType, getter, nullptr);
+  }
+
+  template <typename C, typename T>
+  MetaBuilder&& addProperty(std::string_view name, std::string_view description,
+                            PropertyEditorType editorType,
+                            typename detail::MetaPropertyTraits<C, T>::GetterType getter) && {
+    return std::move(addEntry<C, T>(name, description, editorType, getter, nullptr));
   }
 
   template <typename C, typename T>
-  MetaBuilder& addProperty(const std::string& name, const std::string& description,
+  MetaBuilder& addProperty(std::string_view name, std::string_view description,
                            PropertyEditorType editorType,
                            typename detail::MetaPropertyTraits<C, T>::GetterType getter,
-                           typename detail::MetaPropertyTraits<C, T>::SetterType setter) {
-    m_properties.insert(PropertiesType::value_type(
-        detail::hashName(name), MetaEntry(name, description, editorType,
-                                          std::make_shared<Property<C, T>>(getter, setter))));
-    return *this;
+                           typename detail::MetaPropertyTraits<C, T>::SetterType setter) & {
+    return addEntry<C, T>(name, description, editorType, getter, setter);
   }
 
-  const MetaEntry* getProperty(std::string_view name) const {
-    auto it = m_properties.find(detail::hashName(name));
-    if (it != m_properties.end())
-      return &it->second;
-
-    // The property wasn't found in this class, so let's check the base classes.
-    for (auto base : m_bases) {
-      const MetaEntry* entry = base->getProperty(name);
-      if (entry)
-        return entry;
+  template <typename C, typename T>
+  MetaBuilder&& addProperty(std::string_view name, std::string_view description,
+                            PropertyEditorType editorType,
+                            typename detail::MetaPropertyTraits<C, T>::GetterType getter,
+                            typename detail::MetaPropertyTraits<C, T>::SetterType setter) && {
+    return std::move(addEntry<C, T>(name, description, editorType, getter, setter));
+  }
+
+  // Build the lookup table.  The bases are frozen first.  Calling this more than once, or from
+  // multiple threads, is safe.
+  void freeze() const {
+    if (!isFrozen()) {
+      std::call_once(m_freezeFlag, [this]() {
+        buildLookupTable();
+        m_frozen.store(true, std::memory_order_release);
+      });
     }
+  }
+
+  bool isFrozen() const {
+    return m_frozen.load(std::memory_order_acquire);
+  }
+
+  const MetaEntry* getProperty(std::string_view name) const {
+    return getProperty(PropertyName{name});
+  }
+
+  const MetaEntry* getProperty(const PropertyName& name) const {
+    const uint32_t index = findIndex(name);
+    return index != Slot::kEmpty ? m_table[index] : nullptr;
+  }
+
+  const MetaEntry* getProperty(PropertyHandle handle) const {
+    assert(handle.builder == this);
+    return m_table[handle.index];
+  }
+
+  // Number of properties, including inherited ones.  The properties of a builder can be walked by
+  // index with `PropertyHandle{builder, index}`.
+  size_t getPropertyCount() const {
+    freeze();
+    return m_tableSize;
+  }
+
+  // Number of slots in the lookup table, which grows linearly with the number of properties.
+  size_t getLookupSlotCount() const {
+    freeze();
+    return size_t(1) << (64 - m_shift);
+  }
+
+  // Resolve a property once so that it can be accessed repeatedly without looking up its name.
+  // Returns an invalid handle if the property does not exist.
+  PropertyHandle resolve(std::string_view name) const {
+    return resolve(PropertyName{name});
+  }
 
-    return nullptr;
+  PropertyHandle resolve(const PropertyName& name) const {
+    const uint32_t index = findIndex(name);
+    return index != Slot::kEmpty ? PropertyHandle{this, index} : PropertyHandle{};
   }
 
   void getListOfProperties(std::set<std::string>* outNames) const {
     assert(outNames);
 
-    for (const auto& entry : m_properties) {
-      outNames->insert(entry.second.name);
+    freeze();
+    for (size_t i = 0; i < m_tableSize; ++i) {
+      outNames->emplace(m_table[i]->name);
     }
+  }
 
-    for (const auto& base : m_bases) {
-      base->getListOfProperties(outNames);
-    }
+  // Get the value of one property from `count` objects into `outValues`, calling the getter
+  // directly for each object.  All objects must be of this builder and `T` must be exactly the
+  // type the property was registered with, otherwise false is returned.
+  template <typename T>
+  bool getColumn(PropertyHandle handle, MetaObject* const* objects, size_t count,
+                 T* outValues) const;
+
+  template <typename T>
+  bool getColumn(PropertyHandle handle, const std::vector<MetaObject*>& objects,
+                 std::vector<T>* outValues) const {
+    static_assert(!std::is_same_v<T, bool>, "std::vector<bool> is packed; use a bool array");
+    assert(outValues);
+    outValues->resize(objects.size());
+    return getColumn(handle, objects.data(), objects.size(), outValues->data());
   }
 
+  // Write the value of every property of `obj` into `outSnapshot`, replacing its contents.  A
+  // property that can't be read is left empty and makes the call return false.
+  bool snapshot(MetaObject* obj, Snapshot* outSnapshot) const;
+
+  // Set every writable property of `obj` to its value in `snapshot`, which must have been taken
+  // from an object of this builder.
+  bool restore(MetaObject* obj, const Snapshot& snapshot) const;
+
+  // Fill `outPatch` with the writable properties whose values differ between `from` and `to`,
+  // taking the values from `to`.  Both objects must be of this builder.  Only the properties that
+  // differ are converted to text.
+  bool diff(MetaObject* from, MetaObject* to, Patch* outPatch) const;
+
+  // Set the properties in `patch` on `obj`.
+  bool apply(MetaObject* obj, const Patch& patch) const;
+
 private:
-  PropertiesType m_properties;
-  BasesType m_bases;
+  using Slot = detail::LookupSlot;
+
+  // Everything a builder that is filled in at run time owns.
+  struct Storage {
+    detail::Arena arena;
+    PropertiesType properties;
+    BasesType bases;
+
+    std::vector<const MetaEntry*> table;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> displacements;
+    std::vector<uint32_t> collisions;
+  };
+
+  Storage& getStorage() const {
+    if (!m_storage) {
+      m_storage = std::make_unique<Storage>();
+    }
+    return *m_storage;
+  }
+
+  template <typename C, typename T>
+  MetaBuilder& addEntry(std::string_view name, std::string_view description,
+                        PropertyEditorType editorType,
+                        typename detail::MetaPropertyTraits<C, T>::GetterType getter,
+                        typename detail::MetaPropertyTraits<C, T>::SetterType setter) {
+    // The arena never runs destructors and copies properties as plain values.
+    static_assert(std::is_trivially_copyable_v<Property<C, T>>);
+    assert(!isFrozen());
+
+    Storage& storage = getStorage();
+    void* memory = storage.arena.allocate(sizeof(Property<C, T>), alignof(Property<C, T>));
+    storage.properties.emplace_back(storage.arena.copyString(name),
+                                    storage.arena.copyString(description), editorType,
+                                    new (memory) Property<C, T>(getter, setter));
+    m_entries = storage.properties.data();
+    m_entryCount = storage.properties.size();
+    return *this;
+  }
+
+  uint32_t findIndex(const PropertyName& name) const {
+    freeze();
+
+    const uint32_t displacement =
+        m_displacements[detail::lookupBucketIndex(name.hash, m_bucketShift)];
+    const Slot& slot = m_slots[detail::lookupSlotIndex(name.hash, displacement, m_shift)];
+    if (slot.index == Slot::kEmpty || slot.tag != static_cast<uint32_t>(name.hash)) {
+      return Slot::kEmpty;
+    }
+    if (m_table[slot.index]->name == name.name) {
+      return slot.index;
+    }
+
+    // Names with the exact same hash as a name in the table can't get their own slot.
+    for (size_t i = 0; i < m_collisionCount; ++i) {
+      if (m_table[m_collisions[i]]->name == name.name) {
+        return m_collisions[i];
+      }
+    }
+
+    return Slot::kEmpty;
+  }
+
+  void buildLookupTable() const;
+
+  mutable std::unique_ptr<Storage> m_storage;
+
+  // The definition of the builder, pointing either into `m_storage` or into a `StaticSchema`.
+  const MetaEntry* m_entries = nullptr;
+  size_t m_entryCount = 0;
+  const MetaBuilder* const* m_bases = nullptr;
+  size_t m_baseCount = 0;
+
+  // The frozen lookup table.  `m_table` holds our own and all inherited properties, `m_slots`
+  // indexes into it and `m_displacements` holds the displacement of every bucket of names into
+  // `m_slots`.  `m_collisions` lists the entries whose full hash is equal to the hash of an
+  // entry that already has a slot.
+  mutable const MetaEntry* const* m_table = nullptr;
+  mutable size_t m_tableSize = 0;
+  mutable const Slot* m_slots = nullptr;
+  mutable const uint32_t* m_collisions = nullptr;
+  mutable size_t m_collisionCount = 0;
+  mutable const uint32_t* m_displacements = nullptr;
+  mutable unsigned m_bucketShift = 63;
+  mutable unsigned m_shift = 63;
+  mutable std::once_flag m_freezeFlag;
+  mutable std::atomic<bool> m_frozen{false};
 };
 
+namespace detail {
+
+template <typename C, typename T, typename MetaPropertyTraits<C, T>::GetterType Getter,
+          typename MetaPropertyTraits<C, T>::SetterType Setter>
+inline constexpr Property<C, T> kStaticProperty{Getter, Setter};
+
+} // namespace detail
+
+// Create an entry for a `DEFINE_STATIC_META_OBJECT` table.  The name and description must outlive
+// the table, which string literals do.
+template <typename C, typename T, typename detail::MetaPropertyTraits<C, T>::GetterType Getter,
+          typename detail::MetaPropertyTraits<C, T>::SetterType Setter = nullptr>
+constexpr MetaEntry staticProperty(std::string_view name, std::string_view description,
+                                   PropertyEditorType editorType) {
+  return MetaEntry{name, description, editorType, &detail::kStaticProperty<C, T, Getter, Setter>};
+}
+
+// Computes the lookup table for an array of entries at compile time.
+template <const auto& Entries> struct StaticMetaTable {
+  static constexpr size_t kCount = std::size(Entries);
+
+  static constexpr std::array<size_t, kCount> kHashes = []() {
+    std::array<size_t, kCount> hashes{};
+    for (size_t i = 0; i < kCount; ++i) {
+      hashes[i] = detail::hashName(Entries[i].name);
+    }
+    return hashes;
+  }();
+
+  static constexpr unsigned kSlotBits = detail::lookupTableBits(kCount);
+  static constexpr unsigned kBucketBits = detail::lookupBucketBits(kCount);
+
+  struct Layout {
+    std::array<detail::LookupSlot, size_t(1) << kSlotBits> slots;
+    std::array<uint32_t, size_t(1) << kBucketBits> displacements;
+    bool placed;
+  };
+
+  static constexpr Layout kLayout = []() {
+    Layout layout{};
+    std::array<uint32_t, (size_t(1) << kBucketBits) + 1> bucketStart{};
+    std::array<uint32_t, kCount> order{};
+    layout.placed =
+        detail::placeLookupKeys(kHashes.data(), kCount, kSlotBits, kBucketBits,
+                                layout.displacements.data(), layout.slots.data(),
+                                bucketStart.data(), order.data());
+    return layout;
+  }();
+  // Placing the names also finds equal hashes, which always end up in the same bucket, so this
+  // needs no pairwise check of all the names.
+  static_assert(kLayout.placed, "Static property names (and their hashes) must be unique.");
+
+  static constexpr std::array<const MetaEntry*, kCount> kTable = []() {
+    std::array<const MetaEntry*, kCount> table{};
+    for (size_t i = 0; i < kCount; ++i) {
+      table[i] = &Entries[i];
+    }
+    return table;
+  }();
+
+  static constexpr StaticSchema kSchema = {std::data(Entries),
+                                           kCount,
+                                           nullptr,
+                                           0,
+                                           kTable.data(),
+                                           kCount,
+                                           kLayout.slots.data(),
+                                           kLayout.displacements.data(),
+                                           64 - kBucketBits,
+                                           64 - kSlotBits,
+                                           true};
+};
+
+inline bool MetaObject::get(PropertyHandle handle, std::string* outValue) {
+  if (!handle) {
+    return false;
+  }
+  assert(handle.builder == getMetaBuilder());
+  return handle.builder->getProperty(handle)->prop->get(this, outValue);
+}
+
+inline bool MetaObject::set(PropertyHandle handle, std::string_view value) {
+  if (!handle) {
+    return false;
+  }
+  assert(handle.builder == getMetaBuilder());
+  if (!handle.builder->getProperty(handle)->prop->set(this, value)) {
+    return false;
+  }
+  changed(handle);
+  return true;
+}
+
+inline bool MetaObject::get(const PropertyName& name, std::string* outValue) {
+  return get(getMetaBuilder()->resolve(name), outValue);
+}
+
+inline bool MetaObject::set(const PropertyName& name, std::string_view value) {
+  return set(getMetaBuilder()->resolve(name), value);
+}
+
+inline bool MetaObject::get(PropertyHandle handle, AppendSink sink) {
+  if (!handle) {
+    return false;
+  }
+  assert(handle.builder == getMetaBuilder());
+  return handle.builder->getProperty(handle)->prop->write(this, &sink);
+}
+
+inline bool MetaObject::get(const PropertyName& name, AppendSink sink) {
+  return get(getMetaBuilder()->resolve(name), sink);
+}
+
+inline bool MetaObject::get(std::string_view name, AppendSink sink) {
+  return get(getMetaBuilder()->resolve(name), sink);
+}
+
+inline bool MetaObject::get(PropertyHandle handle, char* buffer, size_t bufferSize,
+                            size_t* outLength) {
+  assert(outLength);
+  detail::BufferWriter writer{buffer, bufferSize};
+  if (!get(handle, AppendSink{&writer})) {
+    return false;
+  }
+  *outLength = writer.length;
+  return writer.length <= bufferSize;
+}
+
+inline bool MetaObject::get(const PropertyName& name, char* buffer, size_t bufferSize,
+                            size_t* outLength) {
+  return get(getMetaBuilder()->resolve(name), buffer, bufferSize, outLength);
+}
+
+inline bool MetaObject::get(std::string_view name, char* buffer, size_t bufferSize,
+                            size_t* outLength) {
+  return get(getMetaBuilder()->resolve(name), buffer, bufferSize, outLength);
+}
+
+template <typename T> bool MetaObject::get(PropertyHandle handle, T* outValue) {
+  if (!handle) {
+    return false;
+  }
+  assert(handle.builder == getMetaBuilder());
+  return handle.builder->getProperty(handle)->prop->getTyped(this, outValue);
+}
+
+template <typename T> bool MetaObject::get(const PropertyName& name, T* outValue) {
+  return get(getMetaBuilder()->resolve(name), outValue);
+}
+
+template <typename T> bool MetaObject::get(std::string_view name, T* outValue) {
+  return get(getMetaBuilder()->resolve(name), outValue);
+}
+
+template <typename T, typename>
+bool MetaObject::set(PropertyHandle handle, const T& value) {
+  if (!handle) {
+    return false;
+  }
+  assert(handle.builder == getMetaBuilder());
+  if (!handle.builder->getProperty(handle)->prop->setTyped(this, value)) {
+    return false;
+  }
+  changed(handle);
+  return true;
+}
+
+inline bool MetaObject::isDirty(PropertyHandle handle) const {
+  assert(handle.builder == getMetaBuilder());
+  if (!isDirtyTrackingEnabled()) {
+    return false;
+  }
+  const std::vector<uint64_t>& dirty = m_state.get()->dirty;
+  return (dirty[handle.index / 64] >> (handle.index % 64)) & 1;
+}
+
+template <typename Func> void MetaObject::forEachDirty(Func&& func) const {
+  if (!isDirtyTrackingEnabled()) {
+    return;
+  }
+  const MetaBuilder* builder = getMetaBuilder();
+  const std::vector<uint64_t>& dirty = m_state.get()->dirty;
+  for (size_t word = 0; word < dirty.size(); ++word) {
+    for (uint64_t bits = dirty[word]; bits; bits &= bits - 1) {
+      func(PropertyHandle{builder,
+                          static_cast<uint32_t>(word * 64 + detail::countTrailingZeros(bits))});
+    }
+  }
+}
+
+template <typename T, typename>
+bool MetaObject::set(const PropertyName& name, const T& value) {
+  return set(getMetaBuilder()->resolve(name), value);
+}
+
+template <typename T, typename>
+bool MetaObject::set(std::string_view name, const T& value) {
+  return set(getMetaBuilder()->resolve(name), value);
+}
+
+template <typename T>
+bool MetaBuilder::getColumn(PropertyHandle handle, MetaObject* const* objects, size_t count,
+                            T* outValues) const {
+  assert(objects || !count);
+  assert(outValues || !count);
+  if (!handle) {
+    return false;
+  }
+  assert(handle.builder == this);
+#ifndef NDEBUG
+  for (size_t i = 0; i < count; ++i) {
+    assert(objects[i]->getMetaBuilder() == this);
+  }
+#endif
+
+  const PropertyBase* prop = getProperty(handle)->prop;
+  if (!prop->hasType<T>()) {
+    return false;
+  }
+  prop->ops->getTypedBatch(prop, objects, count, outValues);
+  return true;
+}
+
 } // namespace meta
 
 #define DECLARE_META_OBJECT(ClassName)                                                             \
@@ -252,31 +1365,54 @@ private:
   static const meta::MetaBuilder m_##ClassName##_properties;                                       \
                                                                                                    \
 public:                                                                                            \
-  static const meta::MetaBuilder* GetStaticMetaBuilder() {                                         \
+  static constexpr const meta::MetaBuilder* GetStaticMetaBuilder() {                               \
     return &m_##ClassName##_properties;                                                            \
   }                                                                                                \
+  using meta::MetaObject::get;                                                                     \
+  using meta::MetaObject::set;                                                                     \
   bool get(std::string_view, std::string*) override;                                               \
-  bool set(std::string_view, const std::string&) override;                                         \
+  bool set(std::string_view, std::string_view) override;                                           \
   const meta::MetaBuilder* getMetaBuilder() const override
 
-#define DEFINE_META_OBJECT(ClassName)                                                              \
+#define DEFINE_META_OBJECT_ACCESSORS(ClassName)                                                    \
   bool ClassName::get(std::string_view name, std::string* outValue) {                              \
-    const meta::MetaEntry* entry = m_##ClassName##_properties.getProperty(name);                   \
-    if (!entry) {                                                                                  \
-      return false;                                                                                \
-    }                                                                                              \
-    return entry->prop->get(this, outValue);                                                       \
+    return get(m_##ClassName##_properties.resolve(name), outValue);                                \
   }                                                                                                \
-  bool ClassName::set(std::string_view name, const std::string& value) {                           \
-    const meta::MetaEntry* entry = m_##ClassName##_properties.getProperty(name);                   \
-    if (!entry) {                                                                                  \
-      return false;                                                                                \
-    }                                                                                              \
-    return entry->prop->set(this, value);                                                          \
+  bool ClassName::set(std::string_view name, std::string_view value) {                             \
+    return set(m_##ClassName##_properties.resolve(name), value);                                   \
   }                                                                                                \
   const meta::MetaBuilder* ClassName::getMetaBuilder() const {                                     \
     return &m_##ClassName##_properties;                                                            \
-  }                                                                                                \
+  }
+
+#define DEFINE_META_OBJECT(ClassName)                                                              \
+  DEFINE_META_OBJECT_ACCESSORS(ClassName)                                                          \
   const meta::MetaBuilder ClassName::m_##ClassName##_properties = meta::MetaBuilder {}
 
+// Define the properties of a class at compile time.  The arguments following the class name are
+// entries created with `meta::staticProperty`.  The property table, including its perfect hash
+// lookup table, is a set of constexpr arrays and the builder is constant initialized, so nothing
+// is allocated or run before `main` (apart from registering the destructor of the builder).
+#define DEFINE_STATIC_META_OBJECT(ClassName, ...)                                                  \
+  DEFINE_META_OBJECT_ACCESSORS(ClassName)                                                          \
+  static constexpr meta::MetaEntry ClassName##_meta_entries[] = {__VA_ARGS__};                     \
+  META_CONSTINIT const meta::MetaBuilder ClassName::m_##ClassName##_properties {                   \
+    meta::StaticMetaTable<ClassName##_meta_entries>::kSchema                                       \
+  }
+
+// Same as `DEFINE_STATIC_META_OBJECT` for a class with a single base.  The entries are still
+// constexpr arrays, but because the base may live in another translation unit, the merged lookup
+// table is built (and allocated) on the first lookup instead of at compile time.
+#define DEFINE_STATIC_DERIVED_META_OBJECT(ClassName, BaseClassName, ...)                           \
+  DEFINE_META_OBJECT_ACCESSORS(ClassName)                                                          \
+  static constexpr meta::MetaEntry ClassName##_meta_entries[] = {__VA_ARGS__};                     \
+  static constexpr const meta::MetaBuilder* ClassName##_meta_bases[] = {                           \
+      BaseClassName::GetStaticMetaBuilder()};                                                      \
+  META_CONSTINIT const meta::MetaBuilder ClassName::m_##ClassName##_properties {                   \
+    meta::StaticSchema {                                                                           \
+      ClassName##_meta_entries, std::size(ClassName##_meta_entries), ClassName##_meta_bases, 1,    \
+          nullptr, 0, nullptr, nullptr, 63, 63, false                                              \
+    }                                                                                              \
+  }
+
 #endif // META_H_
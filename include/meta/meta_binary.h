@@ -0,0 +1,86 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef META_BINARY_H_
+#define META_BINARY_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "meta/meta.h"
+
+namespace meta {
+
+// Reads and writes the state of objects in a compact binary format, driven by the property table
+// of a `MetaBuilder`.  Create one schema per builder and reuse it.
+//
+// The format is:
+//
+//   fingerprint   8 bytes, little endian; identifies the property names and types
+//   count         varint
+//   count times:
+//     id          varint; index of the property in the builder
+//     value
+//
+// Values are encoded by type: integers as varints (zigzag encoded when signed), `float` and
+// `double` as little endian IEEE 754, `bool` as a single byte and `std::string` as a varint length
+// followed by the bytes.  Properties of any other type are stored as their text representation,
+// prefixed with its length.  Read only properties are not written, because they can't be read
+// back.
+class BinarySchema {
+public:
+  explicit BinarySchema(const MetaBuilder* builder);
+
+  const MetaBuilder* getMetaBuilder() const {
+    return m_builder;
+  }
+
+  uint64_t getFingerprint() const {
+    return m_fingerprint;
+  }
+
+  // Append the state of `obj` to `out`.  `obj` must be an object of the schema's builder.
+  bool write(MetaObject* obj, std::string* out) const;
+
+  // Apply the state in `data` to `obj` through its setters.  Fails if the data was written with a
+  // different schema or is malformed; values read before the failure remain applied.
+  bool read(MetaObject* obj, std::string_view data) const;
+
+  struct Codec;
+
+private:
+  struct Field {
+    uint32_t index;
+    const PropertyBase* prop;
+    const Codec* codec;
+  };
+
+  const MetaBuilder* m_builder;
+  uint64_t m_fingerprint;
+  std::vector<Field> m_fields;
+  // Codec by property index, null for properties that are not written.
+  std::vector<const Codec*> m_codecs;
+};
+
+} // namespace meta
+
+#endif // META_BINARY_H_
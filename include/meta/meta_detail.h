@@ -21,13 +21,72 @@
 #ifndef META_DETAIL_H_
 #define META_DETAIL_H_
 
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <memory>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
 
 namespace meta::detail {
 
+// Arena
+
+// Hands out memory from a few large chunks so that objects allocated together sit next to each
+// other.  Addresses stay stable and memory is only released when the arena is destroyed; no
+// destructors are run for the objects stored in it.
+class Arena {
+public:
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  Arena(Arena&&) noexcept = default;
+  Arena& operator=(const Arena&) = delete;
+  Arena& operator=(Arena&&) noexcept = default;
+
+  void* allocate(size_t size, size_t alignment);
+
+  // Copy a string into the arena.
+  std::string_view copyString(std::string_view str);
+
+private:
+  std::vector<std::unique_ptr<char[]>> m_chunks;
+  char* m_current = nullptr;
+  size_t m_remaining = 0;
+};
+
+// TypeId
+
+// A cheap run time tag for a type: the address of a variable that exists once per type.
+using TypeId = const void*;
+
+template <typename T> struct TypeTag {
+  static constexpr char kId = 0;
+};
+
+template <typename T> constexpr TypeId typeId() {
+  return &TypeTag<T>::kId;
+}
+
 // MetaConverter<>
 
-template <typename T> struct MetaConverter {
+// Converts values to and from strings.  The generic version goes through a `std::stringstream`, so
+// any type with stream operators can be used as a property; specialize it for anything else.  A
+// specialization can also provide `template <typename Sink> static bool Write(const T&, Sink*)`,
+// which appends the value to a sink with an `append(const char*, size_t)` member, to avoid a
+// temporary string when a value is written into a larger output.
+//
+// `FromString` takes a `std::string_view`, so values can be read straight out of a larger input
+// buffer.  Specializations that take a `const std::string&` instead still work, at the cost of a
+// copy.
+//
+// Constructing a stream reads the global locale, which serializes threads in some standard
+// libraries.  The specializations below (numbers, `bool` and `std::string`) touch no shared state
+// at all and are safe to use from many threads at once.
+template <typename T, typename Enable = void> struct MetaConverter {
   static bool ToString(const T& inValue, std::string* outValue) {
     assert(outValue);
     std::stringstream iss;
@@ -36,9 +95,9 @@ template <typename T> struct MetaConverter {
     return true;
   }
 
-  static bool FromString(const std::string& inValue, T* outValue) {
+  static bool FromString(std::string_view inValue, T* outValue) {
     assert(outValue);
-    std::stringstream oss(inValue);
+    std::stringstream oss(std::string{inValue});
     oss >> *outValue;
     return true;
   }
@@ -52,12 +111,107 @@ template <> struct MetaConverter<bool> {
     return true;
   }
 
-  static bool FromString(const std::string& inValue, bool* outValue) {
+  template <typename Sink> static bool Write(bool inValue, Sink* sink) {
+    assert(sink);
+    if (inValue) {
+      sink->append("true", 4);
+    } else {
+      sink->append("false", 5);
+    }
+    return true;
+  }
+
+  static bool FromString(std::string_view inValue, bool* outValue) {
     *outValue = (inValue == "true" || inValue == "1");
     return true;
   }
 };
 
+// The white space `std::isspace` accepts in the "C" locale, without consulting the global locale.
+constexpr inline bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// Integers (other than the character types, which streams treat as characters) and floating point
+// numbers are converted with `std::to_chars` and `std::from_chars`.  These work on a buffer on the
+// stack and don't touch the locale.
+template <typename T>
+constexpr bool kIsNumber = (std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+                            !std::is_same_v<T, char> && !std::is_same_v<T, signed char> &&
+                            !std::is_same_v<T, unsigned char> && !std::is_same_v<T, wchar_t> &&
+                            !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>) ||
+                           std::is_floating_point_v<T>;
+
+template <typename T> struct MetaConverter<T, std::enable_if_t<kIsNumber<T>>> {
+  // Enough for the longest shortest round trip representation of any floating point type.
+  static constexpr size_t kBufferSize = 64;
+
+  static bool ToString(T inValue, std::string* outValue) {
+    assert(outValue);
+    char buffer[kBufferSize];
+    auto result = std::to_chars(buffer, buffer + kBufferSize, inValue);
+    if (result.ec != std::errc{}) {
+      return false;
+    }
+    outValue->assign(buffer, result.ptr);
+    return true;
+  }
+
+  template <typename Sink> static bool Write(T inValue, Sink* sink) {
+    assert(sink);
+    char buffer[kBufferSize];
+    auto result = std::to_chars(buffer, buffer + kBufferSize, inValue);
+    if (result.ec != std::errc{}) {
+      return false;
+    }
+    sink->append(buffer, static_cast<size_t>(result.ptr - buffer));
+    return true;
+  }
+
+  // Like the stream version, leading white space is skipped and anything after the number is
+  // ignored.  Unlike it, a string that doesn't start with a number is an error.
+  static bool FromString(std::string_view inValue, T* outValue) {
+    assert(outValue);
+    const char* first = inValue.data();
+    const char* last = first + inValue.size();
+    while (first != last && isSpace(*first)) {
+      ++first;
+    }
+    if (first != last && *first == '+') {
+      ++first;
+    }
+
+    T value{};
+    auto result = std::from_chars(first, last, value);
+    if (result.ec != std::errc{}) {
+      return false;
+    }
+    *outValue = value;
+    return true;
+  }
+};
+
+// Strings are copied as is; the stream version would stop at the first white space.
+template <> struct MetaConverter<std::string> {
+  static bool ToString(const std::string& inValue, std::string* outValue) {
+    assert(outValue);
+    *outValue = inValue;
+    return true;
+  }
+
+  template <typename Sink> static bool Write(const std::string& inValue, Sink* sink) {
+    assert(sink);
+    sink->append(inValue.data(), inValue.size());
+    return true;
+  }
+
+  static bool FromString(std::string_view inValue, std::string* outValue) {
+    assert(outValue);
+    *outValue = inValue;
+    return true;
+  }
+};
+
 // MetaPropertyTraits<>
 
 template <typename C, typename T> struct MetaPropertyTraits {
@@ -0,0 +1,207 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef META_INDEX_H_
+#define META_INDEX_H_
+
+#include <cstddef>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "meta/meta.h"
+
+namespace meta {
+
+// An index of the objects added to it by the value of one property.  The index listens to the
+// objects, so it stays up to date with every `set` (and `markChanged`) without scanning.  Objects
+// are removed automatically when they are destroyed.
+class PropertyIndex : public ChangeListener {
+public:
+  ~PropertyIndex() override;
+
+  PropertyIndex(const PropertyIndex&) = delete;
+  PropertyIndex& operator=(const PropertyIndex&) = delete;
+
+  // False if the property does not exist or does not have the index's key type.
+  bool isValid() const {
+    return m_valid;
+  }
+
+  PropertyHandle getProperty() const {
+    return m_handle;
+  }
+
+  // Objects must be of the builder the index was created for.  Returns false if the index is
+  // invalid.
+  bool add(MetaObject* obj);
+  void remove(MetaObject* obj);
+
+  bool contains(MetaObject* obj) const {
+    return m_objects.count(obj) != 0;
+  }
+
+  size_t size() const {
+    return m_objects.size();
+  }
+
+  void propertyChanged(MetaObject* obj, PropertyHandle handle) override;
+  void objectDestroyed(MetaObject* obj) override;
+
+protected:
+  PropertyIndex(PropertyHandle handle, bool valid) : m_handle(handle), m_valid(valid) {}
+
+  virtual void insert(MetaObject* obj) = 0;
+  virtual void erase(MetaObject* obj) = 0;
+
+  PropertyHandle m_handle;
+
+private:
+  bool m_valid;
+  std::unordered_set<MetaObject*> m_objects;
+};
+
+namespace detail {
+
+template <typename T> bool isIndexable(PropertyHandle handle) {
+  return handle && handle.builder->getProperty(handle)->prop->hasType<T>();
+}
+
+} // namespace detail
+
+// Finds objects by property value in constant time.  `T` must be the type the property was
+// registered with and have a `std::hash`.
+template <typename T> class HashIndex : public PropertyIndex {
+public:
+  explicit HashIndex(PropertyHandle handle)
+      : PropertyIndex(handle, detail::isIndexable<T>(handle)) {}
+
+  HashIndex(const MetaBuilder* builder, std::string_view name)
+      : HashIndex(builder->resolve(name)) {}
+
+  ~HashIndex() override = default;
+
+  // Append the objects whose property equals `key` to `outObjects`, in no particular order.
+  void find(const T& key, std::vector<MetaObject*>* outObjects) const {
+    assert(outObjects);
+    auto it = m_buckets.find(key);
+    if (it != m_buckets.end()) {
+      outObjects->insert(outObjects->end(), it->second.begin(), it->second.end());
+    }
+  }
+
+  size_t count(const T& key) const {
+    auto it = m_buckets.find(key);
+    return it != m_buckets.end() ? it->second.size() : 0;
+  }
+
+protected:
+  void insert(MetaObject* obj) override {
+    T key;
+    obj->get(m_handle, &key);
+    std::vector<MetaObject*>& bucket = m_buckets[key];
+    m_positions.emplace(obj, Position{std::move(key), bucket.size()});
+    bucket.push_back(obj);
+  }
+
+  void erase(MetaObject* obj) override {
+    auto it = m_positions.find(obj);
+    assert(it != m_positions.end());
+    auto bucketIt = m_buckets.find(it->second.key);
+    std::vector<MetaObject*>& bucket = bucketIt->second;
+
+    // Move the last object of the bucket into the hole.
+    MetaObject* last = bucket.back();
+    bucket[it->second.slot] = last;
+    m_positions.find(last)->second.slot = it->second.slot;
+    bucket.pop_back();
+    if (bucket.empty()) {
+      m_buckets.erase(bucketIt);
+    }
+    m_positions.erase(it);
+  }
+
+private:
+  struct Position {
+    T key;
+    // Where the object is in its bucket.
+    size_t slot;
+  };
+
+  std::unordered_map<T, std::vector<MetaObject*>> m_buckets;
+  std::unordered_map<MetaObject*, Position> m_positions;
+};
+
+// Finds objects by property value or range of values in logarithmic time.  `T` must be the type
+// the property was registered with and have an `operator<`.
+template <typename T> class OrderedIndex : public PropertyIndex {
+public:
+  explicit OrderedIndex(PropertyHandle handle)
+      : PropertyIndex(handle, detail::isIndexable<T>(handle)) {}
+
+  OrderedIndex(const MetaBuilder* builder, std::string_view name)
+      : OrderedIndex(builder->resolve(name)) {}
+
+  ~OrderedIndex() override = default;
+
+  // Append the objects whose property equals `key` to `outObjects`, in the order they were added.
+  void find(const T& key, std::vector<MetaObject*>* outObjects) const {
+    assert(outObjects);
+    auto range = m_entries.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+      outObjects->push_back(it->second);
+    }
+  }
+
+  // Append the objects whose property lies in [low, high] to `outObjects`, ordered by value.
+  void findRange(const T& low, const T& high, std::vector<MetaObject*>* outObjects) const {
+    assert(outObjects);
+    for (auto it = m_entries.lower_bound(low); it != m_entries.end() && !(high < it->first);
+         ++it) {
+      outObjects->push_back(it->second);
+    }
+  }
+
+protected:
+  void insert(MetaObject* obj) override {
+    T key;
+    obj->get(m_handle, &key);
+    m_positions.emplace(obj, m_entries.emplace(std::move(key), obj));
+  }
+
+  void erase(MetaObject* obj) override {
+    auto it = m_positions.find(obj);
+    assert(it != m_positions.end());
+    m_entries.erase(it->second);
+    m_positions.erase(it);
+  }
+
+private:
+  using Entries = std::multimap<T, MetaObject*>;
+
+  Entries m_entries;
+  std::unordered_map<MetaObject*, typename Entries::iterator> m_positions;
+};
+
+} // namespace meta
+
+#endif // META_INDEX_H_
@@ -0,0 +1,54 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef META_JSON_H_
+#define META_JSON_H_
+
+#include <cstddef>
+#include <string_view>
+
+#include "meta/meta.h"
+
+namespace meta {
+
+// Streams every property of `obj`, inherited and read only ones included, to `sink` as a single
+// JSON object.  Numbers and bools are written as JSON literals, everything else as strings.
+bool writeJson(MetaObject* obj, AppendSink sink);
+
+// What `readJson` does with a key that names a read only property.
+enum class ReadOnlyKeys {
+  // Parse the value and ignore it, so that the output of `writeJson` can be read back.
+  Skip,
+  // Fail the read.
+  Reject,
+};
+
+// Reads a JSON object from the front of `json` and sets each member on `obj` as soon as it is
+// parsed; no document is built.  Every key must name a property and every value must be a string,
+// number or bool.  Values set before a failure remain applied.
+//
+// When `outConsumed` is given it receives the number of bytes read, so that consecutive objects can
+// be read from one buffer.  Otherwise only whitespace may follow the object.
+bool readJson(MetaObject* obj, std::string_view json, size_t* outConsumed = nullptr,
+              ReadOnlyKeys readOnlyKeys = ReadOnlyKeys::Skip);
+
+} // namespace meta
+
+#endif // META_JSON_H_
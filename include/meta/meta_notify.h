@@ -0,0 +1,84 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef META_NOTIFY_H_
+#define META_NOTIFY_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "meta/meta.h"
+
+namespace meta {
+
+// Queues the property changes of the objects it watches and delivers them in bulk when `flush` is
+// called.  Changes are coalesced: a property that is set several times between two flushes is
+// reported once.
+//
+// Callbacks run inside `flush` and may set properties; those changes are delivered by the next
+// flush.  Subscribing, unsubscribing and destroying watched objects during `flush` is not allowed.
+class ChangeNotifier {
+public:
+  using Callback = std::function<void(MetaObject* obj, PropertyHandle handle)>;
+  using SubscriptionId = uint64_t;
+
+  ChangeNotifier();
+  ~ChangeNotifier();
+
+  ChangeNotifier(const ChangeNotifier&) = delete;
+  ChangeNotifier& operator=(const ChangeNotifier&) = delete;
+
+  // Be told about changes to any property of `obj`.
+  SubscriptionId subscribe(MetaObject* obj, Callback callback);
+
+  // Be told about changes to one property of `obj`.  The handle must belong to the builder of
+  // `obj`.
+  SubscriptionId subscribe(MetaObject* obj, PropertyHandle handle, Callback callback);
+
+  void unsubscribe(SubscriptionId id);
+
+  // Whether any changes are waiting for `flush`.
+  bool hasPending() const {
+    return !m_queue.empty();
+  }
+
+  // Deliver the queued changes, in the order the objects first changed and in property index order
+  // for each object.
+  void flush();
+
+private:
+  class Watch;
+
+  Watch* getWatch(MetaObject* obj);
+  void removeWatch(MetaObject* obj);
+
+  SubscriptionId m_nextId = 1;
+  std::unordered_map<MetaObject*, std::unique_ptr<Watch>> m_watches;
+  std::unordered_map<SubscriptionId, Watch*> m_subscriptions;
+  // Watches with pending changes.
+  std::vector<Watch*> m_queue;
+};
+
+} // namespace meta
+
+#endif // META_NOTIFY_H_
@@ -0,0 +1,100 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef META_PARALLEL_H_
+#define META_PARALLEL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "meta/meta.h"
+
+namespace meta {
+
+// A fixed set of threads that split loops between them.  Every thread starts on an equal share of
+// the range and takes it in chunks, sized so that a chunk takes roughly the same time however
+// expensive the work per element is.  A thread that runs out steals half of the remaining work of
+// another.
+class ThreadPool {
+public:
+  // `threadCount` includes the thread that calls `parallelFor`; 0 uses one per hardware thread.
+  explicit ThreadPool(unsigned threadCount = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  unsigned getThreadCount() const {
+    return static_cast<unsigned>(m_workers.size()) + 1;
+  }
+
+  // Call `body(begin, end)` for chunks that together cover [0, count), on all threads of the pool,
+  // and return when all are done.  Calls from several threads at once run one after the other.
+  void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body);
+
+private:
+  struct alignas(64) Range {
+    std::mutex mutex;
+    size_t begin = 0;
+    size_t end = 0;
+  };
+
+  void workerLoop(unsigned index);
+  void run(unsigned index);
+  bool take(unsigned index, size_t chunkSize, size_t* outBegin, size_t* outEnd);
+  bool steal(unsigned index);
+
+  std::vector<std::thread> m_workers;
+  std::unique_ptr<Range[]> m_ranges;
+
+  std::mutex m_callMutex;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  const std::function<void(size_t, size_t)>* m_body = nullptr;
+  uint64_t m_generation = 0;
+  unsigned m_running = 0;
+  bool m_stop = false;
+};
+
+// Set the property `name` to `value` on every object.  The value is converted once per property
+// type and the property is resolved once per builder; the setters then run on the threads of
+// `pool`.  Dirty tracking and change listeners are updated on the calling thread afterwards.
+//
+// Nothing is set and false is returned when an object has no writable property `name` or the
+// value can't be converted.  The setters must be safe to call for different objects at the same
+// time.
+bool bulkSet(ThreadPool* pool, MetaObject* const* objects, size_t count, std::string_view name,
+             std::string_view value);
+
+inline bool bulkSet(ThreadPool* pool, const std::vector<MetaObject*>& objects,
+                    std::string_view name, std::string_view value) {
+  return bulkSet(pool, objects.data(), objects.size(), name, value);
+}
+
+} // namespace meta
+
+#endif // META_PARALLEL_H_
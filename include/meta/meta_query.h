@@ -0,0 +1,175 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef META_QUERY_H_
+#define META_QUERY_H_
+
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "meta/meta.h"
+
+namespace meta {
+
+enum class CompareOp {
+  Equal,
+  NotEqual,
+  Less,
+  LessEqual,
+  Greater,
+  GreaterEqual,
+};
+
+// Selects the objects of one builder whose properties match a list of conditions, for example
+//
+//   Query(builder).where("count", CompareOp::Greater, 50).where("visible", CompareOp::Equal, true)
+//
+// Conditions are resolved against the builder up front.  Running the query reads each property for
+// a block of objects at a time into a typed column, with the getter called directly, and compares
+// the column without branches, which the compiler can vectorize for numbers.
+class Query {
+public:
+  explicit Query(const MetaBuilder* builder) : m_builder(builder) {
+    assert(builder);
+  }
+
+  // Add a condition that all matches must meet.  `T` must be exactly the type the property was
+  // registered with; otherwise, or if there is no such property, the query becomes invalid.
+  template <typename T> Query& where(PropertyHandle handle, CompareOp op, const T& value);
+
+  template <typename T> Query& where(std::string_view name, CompareOp op, const T& value) {
+    return where(m_builder->resolve(name), op, value);
+  }
+
+  // Text compares against `std::string` properties.
+  Query& where(PropertyHandle handle, CompareOp op, std::string_view value) {
+    return where(handle, op, std::string{value});
+  }
+
+  Query& where(std::string_view name, CompareOp op, std::string_view value) {
+    return where(m_builder->resolve(name), op, std::string{value});
+  }
+
+  Query& where(PropertyHandle handle, CompareOp op, const char* value) {
+    return where(handle, op, std::string_view{value});
+  }
+
+  Query& where(std::string_view name, CompareOp op, const char* value) {
+    return where(name, op, std::string_view{value});
+  }
+
+  bool isValid() const {
+    return m_valid;
+  }
+
+  // Append the objects that match every condition to `outMatches`, in order.  All objects must be
+  // of the query's builder.  Returns false if the query is invalid.
+  bool run(MetaObject* const* objects, size_t count, std::vector<MetaObject*>* outMatches) const;
+
+  bool run(const std::vector<MetaObject*>& objects, std::vector<MetaObject*>* outMatches) const {
+    return run(objects.data(), objects.size(), outMatches);
+  }
+
+  // Objects are processed in blocks of this many.
+  static constexpr size_t kBlockSize = 256;
+
+private:
+  struct Condition {
+    const PropertyBase* prop;
+    CompareOp op;
+    std::any value;
+    // Clears the `mask` entries of the `count` objects that fail the condition.
+    void (*apply)(const Condition&, MetaObject* const* objects, size_t count, uint8_t* mask);
+  };
+
+  template <typename T>
+  static void apply(const Condition& condition, MetaObject* const* objects, size_t count,
+                    uint8_t* mask);
+
+  const MetaBuilder* m_builder;
+  std::vector<Condition> m_conditions;
+  bool m_valid = true;
+};
+
+namespace detail {
+
+template <typename T, typename Compare>
+void compareColumn(const T* column, size_t count, const T& value, Compare compare, uint8_t* mask) {
+  for (size_t i = 0; i < count; ++i) {
+    mask[i] &= static_cast<uint8_t>(compare(column[i], value));
+  }
+}
+
+} // namespace detail
+
+template <typename T> Query& Query::where(PropertyHandle handle, CompareOp op, const T& value) {
+  if (!handle) {
+    m_valid = false;
+    return *this;
+  }
+  assert(handle.builder == m_builder);
+
+  const PropertyBase* prop = m_builder->getProperty(handle)->prop;
+  if (!prop->hasType<T>()) {
+    m_valid = false;
+    return *this;
+  }
+  m_conditions.push_back({prop, op, value, &apply<T>});
+  return *this;
+}
+
+template <typename T>
+void Query::apply(const Condition& condition, MetaObject* const* objects, size_t count,
+                  uint8_t* mask) {
+  assert(count <= kBlockSize);
+  T column[kBlockSize];
+  condition.prop->ops->getTypedBatch(condition.prop, objects, count, column);
+
+  const T& value = *std::any_cast<T>(&condition.value);
+  switch (condition.op) {
+  case CompareOp::Equal:
+    detail::compareColumn(column, count, value, std::equal_to<T>(), mask);
+    break;
+  case CompareOp::NotEqual:
+    detail::compareColumn(column, count, value, std::not_equal_to<T>(), mask);
+    break;
+  case CompareOp::Less:
+    detail::compareColumn(column, count, value, std::less<T>(), mask);
+    break;
+  case CompareOp::LessEqual:
+    detail::compareColumn(column, count, value, std::less_equal<T>(), mask);
+    break;
+  case CompareOp::Greater:
+    detail::compareColumn(column, count, value, std::greater<T>(), mask);
+    break;
+  case CompareOp::GreaterEqual:
+    detail::compareColumn(column, count, value, std::greater_equal<T>(), mask);
+    break;
+  }
+}
+
+} // namespace meta
+
+#endif // META_QUERY_H_
@@ -0,0 +1,139 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef META_STORE_H_
+#define META_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "meta/meta.h"
+
+namespace meta {
+
+// The properties of many objects of one builder in a memory mapped file.  Opening a store only maps
+// the file and checks its layout; values are read straight from the mapping when they are asked
+// for, and the operating system pages the file in as needed.
+//
+// The file has one column per writable property, in property index order, identified by the
+// fingerprint of the builder's `BinarySchema`.  Numbers and bools are stored at their native size
+// and byte order, so a store is meant to be read on the kind of machine that wrote it.  Every
+// other type is stored as its text, in a heap at the end of the file.  Read only properties are not
+// stored.
+//
+// Memory mapping is implemented for POSIX systems; elsewhere `open` fails.
+class PropertyStore {
+public:
+  PropertyStore() = default;
+  ~PropertyStore();
+
+  PropertyStore(const PropertyStore&) = delete;
+  PropertyStore& operator=(const PropertyStore&) = delete;
+
+  // Write the properties of `objects`, which must all be of `builder`, to a new store at `path`.
+  static bool write(const std::string& path, const MetaBuilder* builder,
+                    MetaObject* const* objects, size_t count);
+
+  static bool write(const std::string& path, const MetaBuilder* builder,
+                    const std::vector<MetaObject*>& objects) {
+    return write(path, builder, objects.data(), objects.size());
+  }
+
+  // Map the store at `path`.  Fails if it was not written for `builder` or is damaged.
+  bool open(const std::string& path, const MetaBuilder* builder);
+  void close();
+
+  bool isOpen() const {
+    return m_data != nullptr;
+  }
+
+  const MetaBuilder* getMetaBuilder() const {
+    return m_builder;
+  }
+
+  // Number of objects in the store.
+  size_t size() const {
+    return m_rowCount;
+  }
+
+  // Set every stored property of `obj` to its value for object `row`, through the setters.
+  bool load(size_t row, MetaObject* obj) const;
+
+  // Read one value without an object.  `T` must be exactly the type the property was registered
+  // with.
+  template <typename T> bool get(size_t row, PropertyHandle handle, T* outValue) const;
+
+  // Read one value as its stored text; only for properties that are not stored as numbers.
+  bool getText(size_t row, PropertyHandle handle, std::string_view* outValue) const;
+
+private:
+  struct Field {
+    const PropertyBase* prop = nullptr;
+    // Size of a fixed size value, or 0 for text.
+    uint32_t size = 0;
+    const char* column = nullptr;
+  };
+
+  const Field* getField(PropertyHandle handle) const {
+    assert(handle.builder == m_builder);
+    return handle && handle.index < m_fields.size() && m_fields[handle.index].prop
+               ? &m_fields[handle.index]
+               : nullptr;
+  }
+
+  const MetaBuilder* m_builder = nullptr;
+  const char* m_data = nullptr;
+  size_t m_dataSize = 0;
+  size_t m_rowCount = 0;
+  const char* m_heap = nullptr;
+  size_t m_heapSize = 0;
+  // By property index; fields of properties that are not stored have no `prop`.
+  std::vector<Field> m_fields;
+};
+
+template <typename T>
+bool PropertyStore::get(size_t row, PropertyHandle handle, T* outValue) const {
+  assert(outValue);
+  assert(row < m_rowCount);
+  const Field* field = getField(handle);
+  if (!field || field->size != sizeof(T) || !field->prop->hasType<T>()) {
+    return false;
+  }
+  if constexpr (std::is_same_v<T, bool>) {
+    // Anything but 0 or 1 is not a valid bool; the file is damaged or was not written by us.
+    const auto byte = static_cast<uint8_t>(field->column[row]);
+    if (byte > 1) {
+      return false;
+    }
+    *outValue = byte != 0;
+  } else {
+    std::memcpy(outValue, field->column + row * sizeof(T), sizeof(T));
+  }
+  return true;
+}
+
+} // namespace meta
+
+#endif // META_STORE_H_
@@ -0,0 +1,121 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef META_STREAM_H_
+#define META_STREAM_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "meta/meta.h"
+
+namespace meta {
+
+// A change read from a `ChangeStream`.  `object` identifies the object that changed; it may have
+// been destroyed since and should not be dereferenced unless the consumer knows otherwise.
+struct ChangeRecord {
+  static constexpr size_t kMaxValueSize = 64;
+
+  MetaObject* object = nullptr;
+  PropertyHandle property;
+  // The new value as text, cut off at `kMaxValueSize` bytes.
+  char value[kMaxValueSize];
+  size_t valueSize = 0;
+  bool truncated = false;
+
+  std::string_view getValue() const {
+    return std::string_view{value, valueSize};
+  }
+};
+
+// Publishes the changes made to the objects it watches into a lock free ring buffer that any
+// number of consumers, on any threads, read at their own pace.  The producer never waits: a
+// consumer that falls more than the capacity of the ring behind loses the oldest records and is
+// told how many.
+//
+// The stream has a single producer.  `watch`, `unwatch` and every `set` on the watched objects
+// must happen on one thread.
+class ChangeStream : public ChangeListener {
+public:
+  // `capacity` is rounded up to a power of two.
+  explicit ChangeStream(size_t capacity);
+  ~ChangeStream() override;
+
+  ChangeStream(const ChangeStream&) = delete;
+  ChangeStream& operator=(const ChangeStream&) = delete;
+
+  void watch(MetaObject* obj);
+  void unwatch(MetaObject* obj);
+
+  size_t getCapacity() const {
+    return m_mask + 1;
+  }
+
+  // Reads the records published after it was created.
+  class Consumer {
+  public:
+    explicit Consumer(const ChangeStream& stream);
+
+    // Read the next record.  Returns false when the consumer has caught up.
+    bool poll(ChangeRecord* outRecord);
+
+    // Number of records that were overwritten before this consumer could read them.
+    uint64_t getDropped() const {
+      return m_dropped;
+    }
+
+  private:
+    const ChangeStream* m_stream;
+    uint64_t m_cursor;
+    uint64_t m_dropped = 0;
+  };
+
+  void propertyChanged(MetaObject* obj, PropertyHandle handle) override;
+  void objectDestroyed(MetaObject* obj) override;
+
+private:
+  static constexpr size_t kValueWords = ChangeRecord::kMaxValueSize / sizeof(uint64_t);
+
+  // Slots are guarded by a sequence number: `2 * position + 1` while the record for `position` is
+  // written and `2 * position + 2` once it is complete.  The payload is made of relaxed atomics so
+  // that a consumer racing with the producer reads stale data instead of causing undefined
+  // behavior; it then sees the sequence number change and retries.
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<MetaObject*> object{nullptr};
+    std::atomic<const MetaBuilder*> builder{nullptr};
+    // Property index in the low 32 bits, value size in the high bits.
+    std::atomic<uint64_t> indexAndSize{0};
+    std::atomic<uint64_t> value[kValueWords];
+  };
+
+  std::unique_ptr<Slot[]> m_slots;
+  size_t m_mask;
+  // Position of the next record; written by the producer only.
+  alignas(64) std::atomic<uint64_t> m_head{0};
+  std::vector<MetaObject*> m_watched;
+};
+
+} // namespace meta
+
+#endif // META_STREAM_H_
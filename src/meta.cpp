@@ -20,10 +20,312 @@
 
 #include "meta/meta.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace meta {
 
-MetaObject::~MetaObject() = default;
+namespace {
+
+// Size of the chunks the arena allocates, enough for the properties of most classes.
+constexpr size_t kArenaChunkSize = 1024;
+
+// Bytes reserved per value when a snapshot buffer is first used, so that most objects fit in a
+// single allocation.
+constexpr size_t kSnapshotValueEstimate = 16;
+
+} // namespace
+
+namespace detail {
+
+void* Arena::allocate(size_t size, size_t alignment) {
+  auto padding = [this, alignment]() {
+    return (alignment - reinterpret_cast<uintptr_t>(m_current) % alignment) % alignment;
+  };
+
+  if (padding() + size > m_remaining) {
+    const size_t chunkSize = std::max(kArenaChunkSize, size + alignment);
+    m_chunks.push_back(std::unique_ptr<char[]>{new char[chunkSize]});
+    m_current = m_chunks.back().get();
+    m_remaining = chunkSize;
+  }
+
+  const size_t skip = padding();
+  char* result = m_current + skip;
+  m_current += skip + size;
+  m_remaining -= skip + size;
+  return result;
+}
+
+std::string_view Arena::copyString(std::string_view str) {
+  if (str.empty()) {
+    return {};
+  }
+
+  auto* memory = static_cast<char*>(allocate(str.size(), 1));
+  std::memcpy(memory, str.data(), str.size());
+  return {memory, str.size()};
+}
+
+} // namespace detail
+
+ChangeListener::~ChangeListener() = default;
+
+MetaObject::~MetaObject() {
+  if (detail::ObjectState* state = m_state.get()) {
+    const std::vector<ChangeListener*> listeners = std::move(state->listeners);
+    for (ChangeListener* listener : listeners) {
+      listener->objectDestroyed(this);
+    }
+  }
+}
+
+void MetaObject::enableDirtyTracking() {
+  detail::ObjectState& state = m_state.getOrCreate();
+  if (state.dirty.empty()) {
+    // Never empty, so that it also marks tracking as enabled.
+    state.dirty.assign(getMetaBuilder()->getPropertyCount() / 64 + 1, 0);
+  }
+}
+
+void MetaObject::clearDirty() {
+  if (detail::ObjectState* state = m_state.get()) {
+    std::fill(state->dirty.begin(), state->dirty.end(), 0);
+  }
+}
+
+void MetaObject::addChangeListener(ChangeListener* listener) {
+  assert(listener);
+  m_state.getOrCreate().listeners.push_back(listener);
+}
+
+void MetaObject::removeChangeListener(ChangeListener* listener) {
+  if (detail::ObjectState* state = m_state.get()) {
+    auto& listeners = state->listeners;
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+  }
+}
+
+void MetaObject::notifyChanged(PropertyHandle handle) {
+  detail::ObjectState* state = m_state.get();
+  if (!state->dirty.empty()) {
+    state->dirty[handle.index / 64] |= uint64_t(1) << (handle.index % 64);
+  }
+  for (ChangeListener* listener : state->listeners) {
+    listener->propertyChanged(this, handle);
+  }
+}
+
+MetaBuilder::MetaBuilder(const MetaBuilder& other) {
+  Storage& storage = getStorage();
+
+  storage.bases.assign(other.m_bases, other.m_bases + other.m_baseCount);
+  m_bases = storage.bases.data();
+  m_baseCount = storage.bases.size();
+
+  storage.properties.reserve(other.m_entryCount);
+  for (size_t i = 0; i < other.m_entryCount; ++i) {
+    const MetaEntry& entry = other.m_entries[i];
+    storage.properties.emplace_back(storage.arena.copyString(entry.name),
+                                    storage.arena.copyString(entry.description), entry.editorType,
+                                    entry.prop->ops->clone(entry.prop, &storage.arena));
+  }
+  m_entries = storage.properties.data();
+  m_entryCount = storage.properties.size();
+}
+
+MetaBuilder::MetaBuilder(MetaBuilder&& other) noexcept
+    : m_storage(std::move(other.m_storage)), m_entries(std::exchange(other.m_entries, nullptr)),
+      m_entryCount(std::exchange(other.m_entryCount, 0)),
+      m_bases(std::exchange(other.m_bases, nullptr)),
+      m_baseCount(std::exchange(other.m_baseCount, 0)),
+      m_table(std::exchange(other.m_table, nullptr)),
+      m_tableSize(std::exchange(other.m_tableSize, 0)),
+      m_slots(std::exchange(other.m_slots, nullptr)),
+      m_collisions(std::exchange(other.m_collisions, nullptr)),
+      m_collisionCount(std::exchange(other.m_collisionCount, 0)),
+      m_displacements(std::exchange(other.m_displacements, nullptr)),
+      m_bucketShift(other.m_bucketShift), m_shift(other.m_shift),
+      m_frozen(other.m_frozen.exchange(false)) {}
+
+void MetaBuilder::buildLookupTable() const {
+  // Our own properties, where the first definition of a name wins.
+  std::vector<std::pair<size_t, const MetaEntry*>> own;
+  own.reserve(m_entryCount);
+  for (size_t i = 0; i < m_entryCount; ++i) {
+    const MetaEntry& entry = m_entries[i];
+    auto sameName = [&entry](const auto& key) { return key.second->name == entry.name; };
+    if (std::none_of(own.begin(), own.end(), sameName)) {
+      own.emplace_back(detail::hashName(entry.name), &entry);
+    }
+  }
+
+  // Merge in the already flattened tables of the base classes.  Inherited properties keep the
+  // order of the base tables; when more than one base defines a name, the first base wins.  A
+  // property of our own shadows an inherited one with the same name and takes over its position.
+  std::vector<std::pair<size_t, const MetaEntry*>> keys;
+  std::vector<bool> placed(own.size(), false);
+  for (size_t b = 0; b < m_baseCount; ++b) {
+    const MetaBuilder* base = m_bases[b];
+    base->freeze();
+    for (size_t i = 0; i < base->m_tableSize; ++i) {
+      const MetaEntry* entry = base->m_table[i];
+      auto sameName = [entry](const auto& key) { return key.second->name == entry->name; };
+      if (std::any_of(keys.begin(), keys.end(), sameName)) {
+        continue;
+      }
+      auto shadow = std::find_if(own.begin(), own.end(), sameName);
+      if (shadow != own.end()) {
+        placed[shadow - own.begin()] = true;
+        keys.push_back(*shadow);
+      } else {
+        keys.emplace_back(detail::hashName(entry->name), entry);
+      }
+    }
+  }
+  for (size_t i = 0; i < own.size(); ++i) {
+    if (!placed[i]) {
+      keys.push_back(own[i]);
+    }
+  }
+
+  // Every entry goes into the table, but entries with a hash we have already seen can not be
+  // given a slot of their own.
+  Storage& storage = getStorage();
+  storage.table.clear();
+  storage.table.reserve(keys.size());
+  storage.collisions.clear();
+  std::vector<std::pair<size_t, uint32_t>> slotted;
+  slotted.reserve(keys.size());
+  for (const auto& key : keys) {
+    const uint32_t index = static_cast<uint32_t>(storage.table.size());
+    storage.table.push_back(key.second);
+
+    auto sameHash = [&key](const auto& other) { return other.first == key.first; };
+    if (std::any_of(slotted.begin(), slotted.end(), sameHash)) {
+      storage.collisions.push_back(index);
+    } else {
+      slotted.emplace_back(key.first, index);
+    }
+  }
+
+  // Placing a bucket fails only rarely, in which case we try again with a larger table.
+  std::vector<size_t> hashes(slotted.size());
+  for (size_t i = 0; i < slotted.size(); ++i) {
+    hashes[i] = slotted[i].first;
+  }
+  const unsigned bucketBits = detail::lookupBucketBits(slotted.size());
+  std::vector<uint32_t> displacements(size_t(1) << bucketBits);
+  std::vector<uint32_t> bucketStart(displacements.size() + 1);
+  std::vector<uint32_t> order(slotted.size());
+  for (unsigned bits = detail::lookupTableBits(slotted.size());; ++bits) {
+    std::vector<Slot> slots(size_t(1) << bits);
+    if (!detail::placeLookupKeys(hashes.data(), hashes.size(), bits, bucketBits,
+                                 displacements.data(), slots.data(), bucketStart.data(),
+                                 order.data())) {
+      continue;
+    }
+
+    // Slots refer to positions in `slotted`; point them at the table instead.
+    for (Slot& slot : slots) {
+      if (slot.index != Slot::kEmpty) {
+        slot.index = slotted[slot.index].second;
+      }
+    }
+    storage.slots = std::move(slots);
+    storage.displacements = std::move(displacements);
+
+    m_table = storage.table.data();
+    m_tableSize = storage.table.size();
+    m_slots = storage.slots.data();
+    m_displacements = storage.displacements.data();
+    m_collisions = storage.collisions.data();
+    m_collisionCount = storage.collisions.size();
+    m_bucketShift = 64 - bucketBits;
+    m_shift = 64 - bits;
+    return;
+  }
+}
+
+bool MetaBuilder::snapshot(MetaObject* obj, Snapshot* outSnapshot) const {
+  assert(obj && outSnapshot);
+  assert(obj->getMetaBuilder() == this);
+
+  freeze();
+  outSnapshot->m_builder = this;
+  outSnapshot->m_count = m_tableSize;
+
+  // Keeps the capacity of an earlier snapshot.
+  std::string& buffer = outSnapshot->m_buffer;
+  const size_t headerSize = outSnapshot->getHeaderSize();
+  buffer.resize(headerSize);
+  buffer.reserve(headerSize + m_tableSize * kSnapshotValueEstimate);
+
+  bool result = true;
+  AppendSink sink{&buffer};
+  const auto writeOffset = [&buffer, headerSize](size_t index) {
+    assert(buffer.size() - headerSize <= UINT32_MAX);
+    const auto offset = static_cast<uint32_t>(buffer.size() - headerSize);
+    std::memcpy(&buffer[index * sizeof(uint32_t)], &offset, sizeof(offset));
+  };
+  for (size_t i = 0; i < m_tableSize; ++i) {
+    writeOffset(i);
+    if (!m_table[i]->prop->write(obj, &sink)) {
+      buffer.resize(headerSize + outSnapshot->getOffset(i));
+      result = false;
+    }
+  }
+  writeOffset(m_tableSize);
+  return result;
+}
+
+bool MetaBuilder::restore(MetaObject* obj, const Snapshot& snapshot) const {
+  assert(obj);
+  assert(obj->getMetaBuilder() == this && snapshot.getMetaBuilder() == this);
+
+  bool result = true;
+  for (size_t i = 0; i < snapshot.size(); ++i) {
+    if (!m_table[i]->prop->isReadOnly()) {
+      result &= obj->set(PropertyHandle{this, static_cast<uint32_t>(i)}, snapshot.getValue(i));
+    }
+  }
+  return result;
+}
+
+bool MetaBuilder::diff(MetaObject* from, MetaObject* to, Patch* outPatch) const {
+  assert(from && to && outPatch);
+  assert(from->getMetaBuilder() == this && to->getMetaBuilder() == this);
+
+  freeze();
+  outPatch->m_builder = this;
+  outPatch->m_entries.clear();
+  outPatch->m_values.clear();
+
+  AppendSink sink{&outPatch->m_values};
+  for (size_t i = 0; i < m_tableSize; ++i) {
+    const PropertyBase* prop = m_table[i]->prop;
+    if (prop->isReadOnly() || prop->equals(from, to)) {
+      continue;
+    }
+    if (!prop->write(to, &sink)) {
+      return false;
+    }
+    assert(outPatch->m_values.size() <= UINT32_MAX);
+    outPatch->m_entries.push_back(
+        {static_cast<uint32_t>(i), static_cast<uint32_t>(outPatch->m_values.size())});
+  }
+  return true;
+}
+
+bool MetaBuilder::apply(MetaObject* obj, const Patch& patch) const {
+  assert(obj);
+  assert(obj->getMetaBuilder() == this && patch.getMetaBuilder() == this);
 
-PropertyBase::~PropertyBase() = default;
+  bool result = true;
+  for (size_t i = 0; i < patch.size(); ++i) {
+    result &= obj->set(patch.getHandle(i), patch.getValue(i));
+  }
+  return result;
+}
 
 } // namespace meta
@@ -0,0 +1,347 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "meta/meta_binary.h"
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace meta {
+
+namespace {
+
+struct Reader {
+  const char* pos;
+  const char* end;
+};
+
+void writeVarint(uint64_t value, std::string* out) {
+  char buffer[10];
+  size_t size = 0;
+  while (value >= 0x80) {
+    buffer[size++] = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  buffer[size++] = static_cast<char>(value);
+  out->append(buffer, size);
+}
+
+bool readVarint(Reader* reader, uint64_t* outValue) {
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (reader->pos == reader->end) {
+      return false;
+    }
+    const auto byte = static_cast<uint8_t>(*reader->pos++);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      *outValue = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+void writeFixed(uint64_t value, size_t size, std::string* out) {
+  char buffer[8];
+  for (size_t i = 0; i < size; ++i) {
+    buffer[i] = static_cast<char>(value >> (i * 8));
+  }
+  out->append(buffer, size);
+}
+
+bool readFixed(Reader* reader, size_t size, uint64_t* outValue) {
+  if (static_cast<size_t>(reader->end - reader->pos) < size) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    value |= static_cast<uint64_t>(static_cast<uint8_t>(reader->pos[i])) << (i * 8);
+  }
+  reader->pos += size;
+  *outValue = value;
+  return true;
+}
+
+} // namespace
+
+struct BinarySchema::Codec {
+  detail::TypeId type;
+  // Describes the encoding in the fingerprint.
+  char kind;
+  uint8_t size;
+
+  bool (*write)(const PropertyBase*, MetaObject*, std::string*);
+  bool (*read)(MetaObject*, PropertyHandle, Reader*);
+};
+
+namespace {
+
+using Codec = BinarySchema::Codec;
+
+template <typename T> struct IntCodec {
+  static bool write(const PropertyBase* prop, MetaObject* obj, std::string* out) {
+    T value{};
+    if (!prop->getTyped(obj, &value)) {
+      return false;
+    }
+    if constexpr (std::is_signed_v<T>) {
+      const auto wide = static_cast<int64_t>(value);
+      writeVarint((static_cast<uint64_t>(wide) << 1) ^ static_cast<uint64_t>(wide >> 63), out);
+    } else {
+      writeVarint(static_cast<uint64_t>(value), out);
+    }
+    return true;
+  }
+
+  static bool read(MetaObject* obj, PropertyHandle handle, Reader* reader) {
+    uint64_t raw = 0;
+    if (!readVarint(reader, &raw)) {
+      return false;
+    }
+    if constexpr (std::is_signed_v<T>) {
+      const int64_t wide = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+      if (wide < std::numeric_limits<T>::min() || wide > std::numeric_limits<T>::max()) {
+        return false;
+      }
+      return obj->set(handle, static_cast<T>(wide));
+    } else {
+      if (raw > std::numeric_limits<T>::max()) {
+        return false;
+      }
+      return obj->set(handle, static_cast<T>(raw));
+    }
+  }
+
+  static constexpr Codec kCodec = {detail::typeId<T>(), std::is_signed_v<T> ? 'i' : 'u',
+                                   sizeof(T), &write, &read};
+};
+
+template <typename T, typename Bits> struct FloatCodec {
+  static_assert(sizeof(T) == sizeof(Bits));
+
+  static bool write(const PropertyBase* prop, MetaObject* obj, std::string* out) {
+    T value{};
+    if (!prop->getTyped(obj, &value)) {
+      return false;
+    }
+    Bits bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeFixed(bits, sizeof(bits), out);
+    return true;
+  }
+
+  static bool read(MetaObject* obj, PropertyHandle handle, Reader* reader) {
+    uint64_t raw = 0;
+    if (!readFixed(reader, sizeof(Bits), &raw)) {
+      return false;
+    }
+    const auto bits = static_cast<Bits>(raw);
+    T value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return obj->set(handle, value);
+  }
+
+  static constexpr Codec kCodec = {detail::typeId<T>(), 'f', sizeof(T), &write, &read};
+};
+
+struct BoolCodec {
+  static bool write(const PropertyBase* prop, MetaObject* obj, std::string* out) {
+    bool value = false;
+    if (!prop->getTyped(obj, &value)) {
+      return false;
+    }
+    out->push_back(value ? 1 : 0);
+    return true;
+  }
+
+  static bool read(MetaObject* obj, PropertyHandle handle, Reader* reader) {
+    if (reader->pos == reader->end) {
+      return false;
+    }
+    return obj->set(handle, *reader->pos++ != 0);
+  }
+
+  static constexpr Codec kCodec = {detail::typeId<bool>(), 'b', 1, &write, &read};
+};
+
+// Writes a length followed by the bytes of a string.
+void writeBytes(std::string_view bytes, std::string* out) {
+  writeVarint(bytes.size(), out);
+  out->append(bytes.data(), bytes.size());
+}
+
+bool readBytes(Reader* reader, std::string_view* outBytes) {
+  uint64_t size = 0;
+  if (!readVarint(reader, &size) || size > static_cast<uint64_t>(reader->end - reader->pos)) {
+    return false;
+  }
+  *outBytes = std::string_view{reader->pos, static_cast<size_t>(size)};
+  reader->pos += size;
+  return true;
+}
+
+struct StringCodec {
+  static bool write(const PropertyBase* prop, MetaObject* obj, std::string* out) {
+    std::string value;
+    if (!prop->getTyped(obj, &value)) {
+      return false;
+    }
+    writeBytes(value, out);
+    return true;
+  }
+
+  static bool read(MetaObject* obj, PropertyHandle handle, Reader* reader) {
+    std::string_view bytes;
+    return readBytes(reader, &bytes) && obj->set(handle, bytes);
+  }
+
+  static constexpr Codec kCodec = {detail::typeId<std::string>(), 's', 0, &write, &read};
+};
+
+// Any other type is stored as text.
+struct TextCodec {
+  static bool write(const PropertyBase* prop, MetaObject* obj, std::string* out) {
+    std::string text;
+    if (!prop->get(obj, &text)) {
+      return false;
+    }
+    writeBytes(text, out);
+    return true;
+  }
+
+  static bool read(MetaObject* obj, PropertyHandle handle, Reader* reader) {
+    std::string_view bytes;
+    return readBytes(reader, &bytes) && obj->set(handle, bytes);
+  }
+
+  static constexpr Codec kCodec = {nullptr, 't', 0, &write, &read};
+};
+
+const Codec* const kCodecs[] = {
+    &IntCodec<char>::kCodec,
+    &IntCodec<signed char>::kCodec,
+    &IntCodec<unsigned char>::kCodec,
+    &IntCodec<short>::kCodec,
+    &IntCodec<unsigned short>::kCodec,
+    &IntCodec<int>::kCodec,
+    &IntCodec<unsigned int>::kCodec,
+    &IntCodec<long>::kCodec,
+    &IntCodec<unsigned long>::kCodec,
+    &IntCodec<long long>::kCodec,
+    &IntCodec<unsigned long long>::kCodec,
+    &FloatCodec<float, uint32_t>::kCodec,
+    &FloatCodec<double, uint64_t>::kCodec,
+    &BoolCodec::kCodec,
+    &StringCodec::kCodec,
+};
+
+const Codec* findCodec(detail::TypeId type) {
+  for (const Codec* codec : kCodecs) {
+    if (codec->type == type) {
+      return codec;
+    }
+  }
+  return &TextCodec::kCodec;
+}
+
+constexpr size_t kFingerprintSize = 8;
+
+// FNV-1a.  The fingerprint is stored with every payload, so it must not change with the hash used
+// for the lookup tables.
+uint64_t fingerprintHash(std::string_view data) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const char c : data) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+} // namespace
+
+BinarySchema::BinarySchema(const MetaBuilder* builder) : m_builder(builder) {
+  assert(builder);
+
+  // The fingerprint covers the id, name and encoding of every property we write.
+  std::string descriptor;
+  const size_t count = builder->getPropertyCount();
+  m_codecs.assign(count, nullptr);
+  for (uint32_t i = 0; i < count; ++i) {
+    const MetaEntry* entry = builder->getProperty(PropertyHandle{builder, i});
+    if (entry->prop->isReadOnly()) {
+      continue;
+    }
+
+    const Codec* codec = findCodec(entry->prop->ops->type);
+    m_fields.push_back({i, entry->prop, codec});
+    m_codecs[i] = codec;
+
+    writeVarint(i, &descriptor);
+    descriptor.append(entry->name.data(), entry->name.size());
+    descriptor.push_back('\0');
+    descriptor.push_back(codec->kind);
+    descriptor.push_back(static_cast<char>('0' + codec->size));
+    descriptor.push_back('\0');
+  }
+  m_fingerprint = fingerprintHash(descriptor);
+}
+
+bool BinarySchema::write(MetaObject* obj, std::string* out) const {
+  assert(obj && out);
+  assert(obj->getMetaBuilder() == m_builder);
+
+  writeFixed(m_fingerprint, kFingerprintSize, out);
+  writeVarint(m_fields.size(), out);
+  for (const Field& field : m_fields) {
+    writeVarint(field.index, out);
+    if (!field.codec->write(field.prop, obj, out)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BinarySchema::read(MetaObject* obj, std::string_view data) const {
+  assert(obj);
+  assert(obj->getMetaBuilder() == m_builder);
+
+  Reader reader{data.data(), data.data() + data.size()};
+  uint64_t fingerprint = 0;
+  uint64_t count = 0;
+  if (!readFixed(&reader, kFingerprintSize, &fingerprint) || fingerprint != m_fingerprint ||
+      !readVarint(&reader, &count)) {
+    return false;
+  }
+
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t index = 0;
+    if (!readVarint(&reader, &index) || index >= m_codecs.size() || !m_codecs[index]) {
+      return false;
+    }
+    const PropertyHandle handle{m_builder, static_cast<uint32_t>(index)};
+    if (!m_codecs[index]->read(obj, handle, &reader)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace meta
@@ -0,0 +1,63 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "meta/meta_index.h"
+
+namespace meta {
+
+PropertyIndex::~PropertyIndex() {
+  for (MetaObject* obj : m_objects) {
+    obj->removeChangeListener(this);
+  }
+}
+
+bool PropertyIndex::add(MetaObject* obj) {
+  assert(obj);
+  if (!m_valid) {
+    return false;
+  }
+  assert(obj->getMetaBuilder() == m_handle.builder);
+  if (m_objects.insert(obj).second) {
+    obj->addChangeListener(this);
+    insert(obj);
+  }
+  return true;
+}
+
+void PropertyIndex::remove(MetaObject* obj) {
+  if (m_objects.erase(obj)) {
+    obj->removeChangeListener(this);
+    erase(obj);
+  }
+}
+
+void PropertyIndex::propertyChanged(MetaObject* obj, PropertyHandle handle) {
+  if (handle.index == m_handle.index) {
+    erase(obj);
+    insert(obj);
+  }
+}
+
+void PropertyIndex::objectDestroyed(MetaObject* obj) {
+  m_objects.erase(obj);
+  erase(obj);
+}
+
+} // namespace meta
@@ -0,0 +1,456 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "meta/meta_json.h"
+
+#include <string>
+
+namespace meta {
+
+namespace {
+
+enum class JsonKind {
+  Number,
+  Float,
+  Bool,
+  String,
+};
+
+template <typename... Types> bool isOneOf(detail::TypeId type) {
+  return ((type == detail::typeId<Types>()) || ...);
+}
+
+JsonKind jsonKind(detail::TypeId type) {
+  if (type == detail::typeId<bool>()) {
+    return JsonKind::Bool;
+  }
+  if (isOneOf<float, double, long double>(type)) {
+    return JsonKind::Float;
+  }
+  if (isOneOf<signed char, unsigned char, short, unsigned short, int, unsigned int, long,
+              unsigned long, long long, unsigned long long>(type)) {
+    return JsonKind::Number;
+  }
+  return JsonKind::String;
+}
+
+bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Returns the length of the JSON number at the front of `text`, or 0 if there is none.
+size_t scanNumber(std::string_view text) {
+  size_t pos = 0;
+  const auto digits = [&]() {
+    const size_t start = pos;
+    while (pos < text.size() && isDigit(text[pos])) {
+      ++pos;
+    }
+    return pos > start;
+  };
+
+  if (pos < text.size() && text[pos] == '-') {
+    ++pos;
+  }
+  if (pos < text.size() && text[pos] == '0') {
+    ++pos;
+  } else if (!digits()) {
+    return 0;
+  }
+  if (pos < text.size() && text[pos] == '.') {
+    ++pos;
+    if (!digits()) {
+      return 0;
+    }
+  }
+  if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+    ++pos;
+    if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+      ++pos;
+    }
+    if (!digits()) {
+      return 0;
+    }
+  }
+  return pos;
+}
+
+// Escapes everything appended to it into a JSON string body.
+struct EscapingWriter {
+  AppendSink* sink;
+
+  void append(const char* data, size_t size) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    size_t start = 0;
+    for (size_t i = 0; i < size; ++i) {
+      const auto c = static_cast<unsigned char>(data[i]);
+      if (c >= 0x20 && c != '"' && c != '\\') {
+        continue;
+      }
+      sink->append(data + start, i - start);
+      start = i + 1;
+      char escape[6] = {'\\', static_cast<char>(c), 0, 0, 0, 0};
+      size_t escapeSize = 2;
+      switch (c) {
+      case '"':
+      case '\\':
+        break;
+      case '\b':
+        escape[1] = 'b';
+        break;
+      case '\f':
+        escape[1] = 'f';
+        break;
+      case '\n':
+        escape[1] = 'n';
+        break;
+      case '\r':
+        escape[1] = 'r';
+        break;
+      case '\t':
+        escape[1] = 't';
+        break;
+      default:
+        escape[1] = 'u';
+        escape[2] = '0';
+        escape[3] = '0';
+        escape[4] = kHex[c >> 4];
+        escape[5] = kHex[c & 0xf];
+        escapeSize = 6;
+        break;
+      }
+      sink->append(escape, escapeSize);
+    }
+    sink->append(data + start, size - start);
+  }
+};
+
+bool writeString(MetaObject* obj, PropertyHandle handle, AppendSink* sink) {
+  EscapingWriter writer{sink};
+  sink->append("\"", 1);
+  if (!obj->get(handle, AppendSink{&writer})) {
+    return false;
+  }
+  sink->append("\"", 1);
+  return true;
+}
+
+bool writeValue(MetaObject* obj, PropertyHandle handle, JsonKind kind, AppendSink* sink) {
+  switch (kind) {
+  case JsonKind::Number:
+  case JsonKind::Bool:
+    return obj->get(handle, *sink);
+
+  case JsonKind::Float: {
+    // Infinities and NaN are not JSON numbers; they are written as strings.
+    char buffer[64];
+    size_t length = 0;
+    if (obj->get(handle, buffer, sizeof(buffer), &length)) {
+      const std::string_view text{buffer, length};
+      if (scanNumber(text) == text.size()) {
+        sink->append(buffer, length);
+        return true;
+      }
+    }
+    return writeString(obj, handle, sink);
+  }
+
+  case JsonKind::String:
+    return writeString(obj, handle, sink);
+  }
+  return false;
+}
+
+class JsonParser {
+public:
+  explicit JsonParser(std::string_view text) : m_text(text) {}
+
+  size_t position() const {
+    return m_pos;
+  }
+
+  void skipWhitespace() {
+    while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' ||
+                                     m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) {
+      ++m_pos;
+    }
+  }
+
+  bool atEnd() const {
+    return m_pos == m_text.size();
+  }
+
+  // Consumes `c` after any whitespace.
+  bool consume(char c) {
+    skipWhitespace();
+    if (m_pos < m_text.size() && m_text[m_pos] == c) {
+      ++m_pos;
+      return true;
+    }
+    return false;
+  }
+
+  bool peek(char c) {
+    skipWhitespace();
+    return m_pos < m_text.size() && m_text[m_pos] == c;
+  }
+
+  // Reads a string.  The result points into the input unless the string contains escapes, in
+  // which case it is decoded into `scratch`.
+  bool readString(std::string* scratch, std::string_view* outValue) {
+    if (!consume('"')) {
+      return false;
+    }
+    const size_t start = m_pos;
+    while (m_pos < m_text.size() && m_text[m_pos] != '"' && m_text[m_pos] != '\\') {
+      if (static_cast<unsigned char>(m_text[m_pos]) < 0x20) {
+        return false;
+      }
+      ++m_pos;
+    }
+    if (m_pos == m_text.size()) {
+      return false;
+    }
+    if (m_text[m_pos] == '"') {
+      *outValue = m_text.substr(start, m_pos++ - start);
+      return true;
+    }
+
+    scratch->assign(m_text.data() + start, m_pos - start);
+    while (m_pos < m_text.size()) {
+      const char c = m_text[m_pos++];
+      if (c == '"') {
+        *outValue = *scratch;
+        return true;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return false;
+      }
+      if (c != '\\') {
+        scratch->push_back(c);
+      } else if (!readEscape(scratch)) {
+        return false;
+      }
+    }
+    return false;
+  }
+
+  // Reads a number, `true` or `false` and returns its text.
+  bool readLiteral(std::string_view* outValue) {
+    skipWhitespace();
+    const std::string_view rest = m_text.substr(m_pos);
+    size_t length = scanNumber(rest);
+    if (length == 0) {
+      if (rest.substr(0, 4) == "true") {
+        length = 4;
+      } else if (rest.substr(0, 5) == "false") {
+        length = 5;
+      } else {
+        return false;
+      }
+    }
+    *outValue = rest.substr(0, length);
+    m_pos += length;
+    return true;
+  }
+
+private:
+  bool readHex4(uint32_t* outValue) {
+    if (m_text.size() - m_pos < 4) {
+      return false;
+    }
+    uint32_t value = 0;
+    for (size_t i = 0; i < 4; ++i) {
+      const char c = m_text[m_pos++];
+      value <<= 4;
+      if (isDigit(c)) {
+        value |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        value |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        value |= c - 'A' + 10;
+      } else {
+        return false;
+      }
+    }
+    *outValue = value;
+    return true;
+  }
+
+  bool readEscape(std::string* out) {
+    if (m_pos == m_text.size()) {
+      return false;
+    }
+    switch (m_text[m_pos++]) {
+    case '"':
+      out->push_back('"');
+      return true;
+    case '\\':
+      out->push_back('\\');
+      return true;
+    case '/':
+      out->push_back('/');
+      return true;
+    case 'b':
+      out->push_back('\b');
+      return true;
+    case 'f':
+      out->push_back('\f');
+      return true;
+    case 'n':
+      out->push_back('\n');
+      return true;
+    case 'r':
+      out->push_back('\r');
+      return true;
+    case 't':
+      out->push_back('\t');
+      return true;
+    case 'u':
+      break;
+    default:
+      return false;
+    }
+
+    uint32_t code = 0;
+    if (!readHex4(&code)) {
+      return false;
+    }
+    if (code >= 0xd800 && code < 0xdc00) {
+      uint32_t low = 0;
+      if (m_text.substr(m_pos, 2) != "\\u") {
+        return false;
+      }
+      m_pos += 2;
+      if (!readHex4(&low) || low < 0xdc00 || low >= 0xe000) {
+        return false;
+      }
+      code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+    } else if (code >= 0xdc00 && code < 0xe000) {
+      return false;
+    }
+
+    // Encode as UTF-8.
+    if (code < 0x80) {
+      out->push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      out->push_back(static_cast<char>(0xc0 | (code >> 6)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+      out->push_back(static_cast<char>(0xe0 | (code >> 12)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else {
+      out->push_back(static_cast<char>(0xf0 | (code >> 18)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+    return true;
+  }
+
+  std::string_view m_text;
+  size_t m_pos = 0;
+};
+
+} // namespace
+
+bool writeJson(MetaObject* obj, AppendSink sink) {
+  assert(obj);
+
+  const MetaBuilder* builder = obj->getMetaBuilder();
+  const size_t count = builder->getPropertyCount();
+  sink.append("{", 1);
+  for (uint32_t i = 0; i < count; ++i) {
+    const PropertyHandle handle{builder, i};
+    const MetaEntry* entry = builder->getProperty(handle);
+    sink.append(i == 0 ? "\"" : ",\"", i == 0 ? 1 : 2);
+    EscapingWriter{&sink}.append(entry->name.data(), entry->name.size());
+    sink.append("\":", 2);
+    if (!writeValue(obj, handle, jsonKind(entry->prop->ops->type), &sink)) {
+      return false;
+    }
+  }
+  sink.append("}", 1);
+  return true;
+}
+
+bool readJson(MetaObject* obj, std::string_view json, size_t* outConsumed,
+              ReadOnlyKeys readOnlyKeys) {
+  assert(obj);
+
+  const MetaBuilder* builder = obj->getMetaBuilder();
+  JsonParser parser{json};
+  std::string keyScratch;
+  std::string valueScratch;
+
+  if (!parser.consume('{')) {
+    return false;
+  }
+  if (!parser.consume('}')) {
+    do {
+      std::string_view key;
+      std::string_view value;
+      if (!parser.readString(&keyScratch, &key) || !parser.consume(':')) {
+        return false;
+      }
+      const PropertyHandle handle = builder->resolve(key);
+      if (!handle) {
+        return false;
+      }
+      if (parser.peek('"')) {
+        if (!parser.readString(&valueScratch, &value)) {
+          return false;
+        }
+      } else if (!parser.readLiteral(&value)) {
+        return false;
+      }
+      const PropertyBase* prop = builder->getProperty(handle)->prop;
+      if (prop->isReadOnly()) {
+        if (readOnlyKeys == ReadOnlyKeys::Reject) {
+          return false;
+        }
+        continue;
+      }
+      // The integer converters stop at the first non-digit, so a fraction or exponent would
+      // otherwise be truncated silently.
+      if (jsonKind(prop->ops->type) == JsonKind::Number &&
+          value.find_first_of(".eE") != std::string_view::npos) {
+        return false;
+      }
+      if (!obj->set(handle, value)) {
+        return false;
+      }
+    } while (parser.consume(','));
+
+    if (!parser.consume('}')) {
+      return false;
+    }
+  }
+
+  if (outConsumed) {
+    *outConsumed = parser.position();
+    return true;
+  }
+  parser.skipWhitespace();
+  return parser.atEnd();
+}
+
+} // namespace meta
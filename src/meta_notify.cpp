@@ -0,0 +1,199 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "meta/meta_notify.h"
+
+#include <algorithm>
+
+namespace meta {
+
+// Subscriptions to one object.  Changes are marked in a bitmap by property index and the watch
+// is queued on its first change.
+class ChangeNotifier::Watch : public ChangeListener {
+public:
+  static constexpr uint32_t kAllProperties = UINT32_MAX;
+
+  struct Subscription {
+    SubscriptionId id;
+    // Property index or `kAllProperties`.
+    uint32_t index;
+    Callback callback;
+  };
+
+  Watch(ChangeNotifier* notifier, MetaObject* obj)
+      : m_notifier(notifier), m_obj(obj),
+        m_pending(obj->getMetaBuilder()->getPropertyCount() / 64 + 1, 0),
+        m_interest(m_pending.size(), 0) {
+    obj->addChangeListener(this);
+  }
+
+  ~Watch() override {
+    if (m_obj) {
+      m_obj->removeChangeListener(this);
+    }
+  }
+
+  void add(SubscriptionId id, uint32_t index, Callback callback) {
+    m_subscriptions.push_back({id, index, std::move(callback)});
+    updateInterest();
+  }
+
+  void remove(SubscriptionId id) {
+    auto sameId = [id](const Subscription& subscription) { return subscription.id == id; };
+    m_subscriptions.erase(
+        std::remove_if(m_subscriptions.begin(), m_subscriptions.end(), sameId),
+        m_subscriptions.end());
+    updateInterest();
+  }
+
+  MetaObject* getObject() const {
+    return m_obj;
+  }
+
+  bool empty() const {
+    return m_subscriptions.empty();
+  }
+
+  void propertyChanged(MetaObject* /*obj*/, PropertyHandle handle) override {
+    const size_t word = handle.index / 64;
+    const uint64_t bit = uint64_t(1) << (handle.index % 64);
+    if (!(m_interest[word] & bit)) {
+      return;
+    }
+    m_pending[word] |= bit;
+    if (!m_queued) {
+      m_queued = true;
+      m_notifier->m_queue.push_back(this);
+    }
+  }
+
+  void objectDestroyed(MetaObject* obj) override {
+    // Changes made before the object went away can no longer be delivered.
+    m_obj = nullptr;
+    m_notifier->removeWatch(obj);
+  }
+
+  void deliver() {
+    m_queued = false;
+    // Take the pending bits first, so that changes made by the callbacks are queued again.
+    std::vector<uint64_t> pending(m_pending.size(), 0);
+    pending.swap(m_pending);
+
+    const MetaBuilder* builder = m_obj->getMetaBuilder();
+    for (size_t word = 0; word < pending.size(); ++word) {
+      for (uint64_t bits = pending[word]; bits; bits &= bits - 1) {
+        const auto index = static_cast<uint32_t>(word * 64 + detail::countTrailingZeros(bits));
+        for (const Subscription& subscription : m_subscriptions) {
+          if (subscription.index == index || subscription.index == kAllProperties) {
+            subscription.callback(m_obj, PropertyHandle{builder, index});
+          }
+        }
+      }
+    }
+  }
+
+private:
+  void updateInterest() {
+    std::fill(m_interest.begin(), m_interest.end(), 0);
+    for (const Subscription& subscription : m_subscriptions) {
+      if (subscription.index == kAllProperties) {
+        std::fill(m_interest.begin(), m_interest.end(), ~uint64_t(0));
+        return;
+      }
+      m_interest[subscription.index / 64] |= uint64_t(1) << (subscription.index % 64);
+    }
+  }
+
+  ChangeNotifier* m_notifier;
+  MetaObject* m_obj;
+  std::vector<Subscription> m_subscriptions;
+  std::vector<uint64_t> m_pending;
+  // Properties that have at least one subscription.
+  std::vector<uint64_t> m_interest;
+  bool m_queued = false;
+};
+
+ChangeNotifier::ChangeNotifier() = default;
+
+ChangeNotifier::~ChangeNotifier() = default;
+
+ChangeNotifier::SubscriptionId ChangeNotifier::subscribe(MetaObject* obj, Callback callback) {
+  assert(obj && callback);
+  const SubscriptionId id = m_nextId++;
+  Watch* watch = getWatch(obj);
+  watch->add(id, Watch::kAllProperties, std::move(callback));
+  m_subscriptions.emplace(id, watch);
+  return id;
+}
+
+ChangeNotifier::SubscriptionId ChangeNotifier::subscribe(MetaObject* obj, PropertyHandle handle,
+                                                         Callback callback) {
+  assert(obj && handle && callback);
+  assert(handle.builder == obj->getMetaBuilder());
+  const SubscriptionId id = m_nextId++;
+  Watch* watch = getWatch(obj);
+  watch->add(id, handle.index, std::move(callback));
+  m_subscriptions.emplace(id, watch);
+  return id;
+}
+
+void ChangeNotifier::unsubscribe(SubscriptionId id) {
+  auto it = m_subscriptions.find(id);
+  if (it == m_subscriptions.end()) {
+    return;
+  }
+  Watch* watch = it->second;
+  m_subscriptions.erase(it);
+  watch->remove(id);
+  if (watch->empty()) {
+    removeWatch(watch->getObject());
+  }
+}
+
+void ChangeNotifier::flush() {
+  std::vector<Watch*> queue;
+  queue.swap(m_queue);
+  for (Watch* watch : queue) {
+    watch->deliver();
+  }
+}
+
+ChangeNotifier::Watch* ChangeNotifier::getWatch(MetaObject* obj) {
+  std::unique_ptr<Watch>& watch = m_watches[obj];
+  if (!watch) {
+    watch = std::make_unique<Watch>(this, obj);
+  }
+  return watch.get();
+}
+
+void ChangeNotifier::removeWatch(MetaObject* obj) {
+  auto it = m_watches.find(obj);
+  if (it == m_watches.end()) {
+    return;
+  }
+  Watch* watch = it->second.get();
+  m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), watch), m_queue.end());
+  for (auto sub = m_subscriptions.begin(); sub != m_subscriptions.end();) {
+    sub = sub->second == watch ? m_subscriptions.erase(sub) : std::next(sub);
+  }
+  m_watches.erase(it);
+}
+
+} // namespace meta
@@ -0,0 +1,293 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "meta/meta_parallel.h"
+
+#include <algorithm>
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace meta {
+
+namespace {
+
+// Chunks are grown or shrunk to take about this long, which keeps the locking cost of taking a
+// chunk small while leaving enough chunks to balance the load.
+constexpr auto kTargetChunkTime = std::chrono::microseconds(50);
+constexpr size_t kInitialChunkSize = 16;
+constexpr size_t kMaxChunkSize = 1 << 16;
+
+// Below this many elements the work is done on the calling thread.
+constexpr size_t kMinParallelCount = 256;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_ranges = std::make_unique<Range[]>(threadCount);
+  for (unsigned i = 1; i < threadCount; ++i) {
+    m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (std::thread& worker : m_workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t)>& body) {
+  if (count == 0) {
+    return;
+  }
+  if (m_workers.empty() || count < kMinParallelCount) {
+    body(0, count);
+    return;
+  }
+
+  std::lock_guard<std::mutex> callLock(m_callMutex);
+  const unsigned threadCount = getThreadCount();
+  for (unsigned i = 0; i < threadCount; ++i) {
+    std::lock_guard<std::mutex> lock(m_ranges[i].mutex);
+    m_ranges[i].begin = count * i / threadCount;
+    m_ranges[i].end = count * (i + 1) / threadCount;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_body = &body;
+    m_running = static_cast<unsigned>(m_workers.size());
+    ++m_generation;
+  }
+  m_wake.notify_all();
+
+  run(0);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this]() { return m_running == 0; });
+  m_body = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+  uint64_t generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&]() { return m_stop || m_generation != generation; });
+      if (m_stop) {
+        return;
+      }
+      generation = m_generation;
+    }
+
+    run(index);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_running == 0) {
+      m_done.notify_one();
+    }
+  }
+}
+
+void ThreadPool::run(unsigned index) {
+  using Clock = std::chrono::steady_clock;
+
+  size_t chunkSize = kInitialChunkSize;
+  for (;;) {
+    size_t begin = 0;
+    size_t end = 0;
+    if (!take(index, chunkSize, &begin, &end)) {
+      if (!steal(index)) {
+        return;
+      }
+      continue;
+    }
+
+    const auto start = Clock::now();
+    (*m_body)(begin, end);
+    const auto elapsed = Clock::now() - start;
+
+    if (elapsed < kTargetChunkTime / 2 && chunkSize < kMaxChunkSize) {
+      chunkSize *= 2;
+    } else if (elapsed > kTargetChunkTime * 2 && chunkSize > 1) {
+      chunkSize /= 2;
+    }
+  }
+}
+
+bool ThreadPool::take(unsigned index, size_t chunkSize, size_t* outBegin, size_t* outEnd) {
+  Range& range = m_ranges[index];
+  std::lock_guard<std::mutex> lock(range.mutex);
+  if (range.begin == range.end) {
+    return false;
+  }
+  *outBegin = range.begin;
+  *outEnd = std::min(range.end, range.begin + chunkSize);
+  range.begin = *outEnd;
+  return true;
+}
+
+bool ThreadPool::steal(unsigned index) {
+  const unsigned threadCount = getThreadCount();
+  for (unsigned i = 1; i < threadCount; ++i) {
+    Range& victim = m_ranges[(index + i) % threadCount];
+    size_t begin = 0;
+    size_t end = 0;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      const size_t remaining = victim.end - victim.begin;
+      if (remaining == 0) {
+        continue;
+      }
+      // Take the back half, the part the victim would reach last.
+      begin = victim.end - (remaining + 1) / 2;
+      end = victim.end;
+      victim.end = begin;
+    }
+
+    Range& own = m_ranges[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.begin = begin;
+    own.end = end;
+    return true;
+  }
+  return false;
+}
+
+bool bulkSet(ThreadPool* pool, MetaObject* const* objects, size_t count, std::string_view name,
+             std::string_view value) {
+  assert(pool);
+  assert(objects || !count);
+
+  struct Parsed {
+    detail::TypeId type;
+    std::any value;
+  };
+  // The objects of one builder, in their original order.  Most collections hold very few classes,
+  // so groups are searched linearly.
+  struct Group {
+    const MetaBuilder* builder;
+    PropertyHandle handle;
+    const PropertyBase* prop;
+    const std::any* value;
+    std::vector<MetaObject*> objects;
+  };
+  std::vector<std::unique_ptr<Parsed>> parsed;
+  std::vector<Group> groups;
+
+  const auto addGroup = [&](const MetaBuilder* builder) -> Group* {
+    const PropertyHandle handle = builder->resolve(name);
+    if (!handle || builder->getProperty(handle)->prop->isReadOnly()) {
+      return nullptr;
+    }
+    const PropertyBase* prop = builder->getProperty(handle)->prop;
+
+    // Convert the value once per type.
+    const detail::TypeId type = prop->ops->type;
+    auto sameType = [type](const auto& p) { return p->type == type; };
+    auto it = std::find_if(parsed.begin(), parsed.end(), sameType);
+    if (it == parsed.end()) {
+      auto entry = std::make_unique<Parsed>(Parsed{type, {}});
+      if (!prop->ops->parse(value, &entry->value)) {
+        return nullptr;
+      }
+      it = parsed.insert(parsed.end(), std::move(entry));
+    }
+    groups.push_back({builder, handle, prop, &(*it)->value, {}});
+    return &groups.back();
+  };
+
+  const auto apply = [pool](const Group& group, MetaObject* const* groupObjects, size_t size) {
+    std::atomic<bool> failed{false};
+    std::mutex observedMutex;
+    std::vector<size_t> observed;
+    pool->parallelFor(size, [&](size_t begin, size_t end) {
+      if (!group.prop->ops->setTypedBatch(group.prop, groupObjects + begin, end - begin,
+                                          *group.value)) {
+        failed.store(true, std::memory_order_relaxed);
+        return;
+      }
+      // Checked while the chunk is still in cache.
+      for (size_t i = begin; i < end; ++i) {
+        if (groupObjects[i]->isObserved()) {
+          std::lock_guard<std::mutex> lock(observedMutex);
+          observed.push_back(i);
+        }
+      }
+    });
+
+    // Listeners are not thread safe, so they hear about the changes here, in order.
+    std::sort(observed.begin(), observed.end());
+    for (size_t i : observed) {
+      groupObjects[i]->markChanged(group.handle);
+    }
+    return !failed.load(std::memory_order_relaxed);
+  };
+
+  if (count == 0) {
+    return true;
+  }
+
+  // Usually all objects share a builder and can be used in place.
+  const MetaBuilder* first = objects[0]->getMetaBuilder();
+  std::atomic<bool> uniform{true};
+  pool->parallelFor(count, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end && uniform.load(std::memory_order_relaxed); ++i) {
+      if (objects[i]->getMetaBuilder() != first) {
+        uniform.store(false, std::memory_order_relaxed);
+      }
+    }
+  });
+  if (uniform.load(std::memory_order_relaxed)) {
+    const Group* group = addGroup(first);
+    return group && apply(*group, objects, count);
+  }
+
+  Group* group = nullptr;
+  for (size_t i = 0; i < count; ++i) {
+    const MetaBuilder* builder = objects[i]->getMetaBuilder();
+    if (!group || group->builder != builder) {
+      auto sameBuilder = [builder](const Group& g) { return g.builder == builder; };
+      auto it = std::find_if(groups.begin(), groups.end(), sameBuilder);
+      group = it != groups.end() ? &*it : addGroup(builder);
+      if (!group) {
+        return false;
+      }
+    }
+    group->objects.push_back(objects[i]);
+  }
+
+  bool result = true;
+  for (const Group& g : groups) {
+    result &= apply(g, g.objects.data(), g.objects.size());
+  }
+  return result;
+}
+
+} // namespace meta
@@ -0,0 +1,64 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "meta/meta_query.h"
+
+#include <algorithm>
+
+namespace meta {
+
+bool Query::run(MetaObject* const* objects, size_t count,
+                std::vector<MetaObject*>* outMatches) const {
+  assert(objects || !count);
+  assert(outMatches);
+  if (!m_valid) {
+    return false;
+  }
+
+  for (size_t blockStart = 0; blockStart < count; blockStart += kBlockSize) {
+    MetaObject* const* block = objects + blockStart;
+    const size_t blockCount = std::min(kBlockSize, count - blockStart);
+#ifndef NDEBUG
+    for (size_t i = 0; i < blockCount; ++i) {
+      assert(block[i]->getMetaBuilder() == m_builder);
+    }
+#endif
+
+    uint8_t mask[kBlockSize];
+    std::fill(mask, mask + blockCount, uint8_t(1));
+    for (const Condition& condition : m_conditions) {
+      condition.apply(condition, block, blockCount, mask);
+    }
+
+    // Write every object and advance past the matching ones.
+    const size_t start = outMatches->size();
+    outMatches->resize(start + blockCount);
+    MetaObject** out = outMatches->data() + start;
+    size_t matches = 0;
+    for (size_t i = 0; i < blockCount; ++i) {
+      out[matches] = block[i];
+      matches += mask[i];
+    }
+    outMatches->resize(start + matches);
+  }
+  return true;
+}
+
+} // namespace meta
@@ -0,0 +1,294 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "meta/meta_store.h"
+
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define META_HAVE_MMAP 1
+#endif
+
+#include "meta/meta_binary.h"
+
+namespace meta {
+
+namespace {
+
+constexpr char kMagic[8] = {'M', 'E', 'T', 'A', 'S', 'T', 'O', '1'};
+// Written in native byte order, to recognize stores from machines with another one.
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t byteOrder;
+  uint32_t fieldCount;
+  uint64_t fingerprint;
+  uint64_t rowCount;
+  uint64_t heapOffset;
+};
+
+struct FieldHeader {
+  uint32_t index;
+  // Size of a fixed size value, or 0 for text.
+  uint32_t size;
+  uint64_t offset;
+};
+
+// Where the text of a value is in the heap.
+struct TextEntry {
+  uint64_t offset;
+  uint64_t size;
+};
+
+template <typename... Types> uint32_t sizeOfOneOf(detail::TypeId type) {
+  uint32_t size = 0;
+  ((type == detail::typeId<Types>() ? (size = sizeof(Types), true) : false) || ...);
+  return size;
+}
+
+// Size of the properties stored as their native value, 0 for the ones stored as text.
+uint32_t fixedSize(detail::TypeId type) {
+  return sizeOfOneOf<bool, char, signed char, unsigned char, short, unsigned short, int,
+                     unsigned int, long, unsigned long, long long, unsigned long long, float,
+                     double>(type);
+}
+
+uint64_t alignUp(uint64_t value) {
+  return (value + 7) & ~uint64_t(7);
+}
+
+struct StoredField {
+  uint32_t index;
+  const PropertyBase* prop;
+  uint32_t size;
+};
+
+std::vector<StoredField> storedFields(const MetaBuilder* builder) {
+  std::vector<StoredField> fields;
+  const size_t count = builder->getPropertyCount();
+  for (uint32_t i = 0; i < count; ++i) {
+    const PropertyBase* prop = builder->getProperty(PropertyHandle{builder, i})->prop;
+    if (!prop->isReadOnly()) {
+      fields.push_back({i, prop, fixedSize(prop->ops->type)});
+    }
+  }
+  return fields;
+}
+
+} // namespace
+
+PropertyStore::~PropertyStore() {
+  close();
+}
+
+bool PropertyStore::write(const std::string& path, const MetaBuilder* builder,
+                          MetaObject* const* objects, size_t count) {
+  assert(builder);
+  assert(objects || !count);
+
+  const std::vector<StoredField> fields = storedFields(builder);
+
+  // Columns follow the header and field table, each aligned to 8 bytes; the heap comes last.
+  FileHeader header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.byteOrder = kByteOrderMark;
+  header.fieldCount = static_cast<uint32_t>(fields.size());
+  header.fingerprint = BinarySchema(builder).getFingerprint();
+  header.rowCount = count;
+
+  std::vector<FieldHeader> fieldHeaders;
+  uint64_t offset = alignUp(sizeof(FileHeader) + fields.size() * sizeof(FieldHeader));
+  for (const StoredField& field : fields) {
+    fieldHeaders.push_back({field.index, field.size, offset});
+    offset = alignUp(offset + count * (field.size ? field.size : sizeof(TextEntry)));
+  }
+  header.heapOffset = offset;
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(fieldHeaders.data()),
+             fieldHeaders.size() * sizeof(FieldHeader));
+
+  std::string heap;
+  AppendSink heapSink{&heap};
+  std::string column;
+  for (size_t f = 0; f < fields.size(); ++f) {
+    const StoredField& field = fields[f];
+    const auto position = static_cast<uint64_t>(file.tellp());
+    assert(position <= fieldHeaders[f].offset);
+    file.write("\0\0\0\0\0\0\0", static_cast<std::streamsize>(fieldHeaders[f].offset - position));
+
+    column.clear();
+    for (size_t row = 0; row < count; ++row) {
+      assert(objects[row]->getMetaBuilder() == builder);
+      if (field.size) {
+        // Fixed size values are trivially copyable, so their bytes can be copied out.
+        alignas(8) char value[8] = {};
+        if (!field.prop->ops->getTyped(field.prop, objects[row], value)) {
+          return false;
+        }
+        column.append(value, field.size);
+      } else {
+        TextEntry entry = {heap.size(), 0};
+        if (!field.prop->write(objects[row], &heapSink)) {
+          return false;
+        }
+        entry.size = heap.size() - entry.offset;
+        column.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+      }
+    }
+    file.write(column.data(), static_cast<std::streamsize>(column.size()));
+  }
+
+  const auto position = static_cast<uint64_t>(file.tellp());
+  file.write("\0\0\0\0\0\0\0", static_cast<std::streamsize>(header.heapOffset - position));
+  file.write(heap.data(), static_cast<std::streamsize>(heap.size()));
+  return static_cast<bool>(file);
+}
+
+bool PropertyStore::open(const std::string& path, const MetaBuilder* builder) {
+  assert(builder);
+  close();
+
+#if defined(META_HAVE_MMAP)
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+    ::close(fd);
+    return false;
+  }
+  void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  m_data = static_cast<const char*>(mapping);
+  m_dataSize = static_cast<size_t>(info.st_size);
+  m_builder = builder;
+#else
+  (void)path;
+  return false;
+#endif
+
+  // The mapping is page aligned, so the header and columns can be read in place.
+  const auto* header = reinterpret_cast<const FileHeader*>(m_data);
+  const std::vector<StoredField> fields = storedFields(builder);
+  const uint64_t tableEnd = sizeof(FileHeader) + uint64_t(header->fieldCount) * sizeof(FieldHeader);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->byteOrder != kByteOrderMark || header->fieldCount != fields.size() ||
+      header->fingerprint != BinarySchema(builder).getFingerprint() || tableEnd > m_dataSize ||
+      header->heapOffset > m_dataSize) {
+    close();
+    return false;
+  }
+
+  m_rowCount = static_cast<size_t>(header->rowCount);
+  m_heap = m_data + header->heapOffset;
+  m_heapSize = m_dataSize - header->heapOffset;
+  m_fields.assign(builder->getPropertyCount(), Field{});
+
+  const auto* fieldHeaders = reinterpret_cast<const FieldHeader*>(m_data + sizeof(FileHeader));
+  for (size_t f = 0; f < fields.size(); ++f) {
+    const FieldHeader& fieldHeader = fieldHeaders[f];
+    const uint64_t valueSize = fields[f].size ? fields[f].size : sizeof(TextEntry);
+    if (fieldHeader.index != fields[f].index || fieldHeader.size != fields[f].size ||
+        fieldHeader.offset % 8 != 0 || fieldHeader.offset > header->heapOffset ||
+        (header->heapOffset - fieldHeader.offset) / valueSize < header->rowCount) {
+      close();
+      return false;
+    }
+    m_fields[fieldHeader.index] = {fields[f].prop, fields[f].size, m_data + fieldHeader.offset};
+  }
+  return true;
+}
+
+void PropertyStore::close() {
+#if defined(META_HAVE_MMAP)
+  if (m_data) {
+    ::munmap(const_cast<char*>(m_data), m_dataSize);
+  }
+#endif
+  m_builder = nullptr;
+  m_data = nullptr;
+  m_dataSize = 0;
+  m_rowCount = 0;
+  m_heap = nullptr;
+  m_heapSize = 0;
+  m_fields.clear();
+}
+
+bool PropertyStore::getText(size_t row, PropertyHandle handle, std::string_view* outValue) const {
+  assert(outValue);
+  assert(row < m_rowCount);
+  const Field* field = getField(handle);
+  if (!field || field->size) {
+    return false;
+  }
+  TextEntry entry;
+  std::memcpy(&entry, field->column + row * sizeof(TextEntry), sizeof(entry));
+  if (entry.offset > m_heapSize || entry.size > m_heapSize - entry.offset) {
+    return false;
+  }
+  *outValue = std::string_view{m_heap + entry.offset, static_cast<size_t>(entry.size)};
+  return true;
+}
+
+bool PropertyStore::load(size_t row, MetaObject* obj) const {
+  assert(obj);
+  assert(row < m_rowCount);
+  assert(obj->getMetaBuilder() == m_builder);
+
+  bool result = true;
+  for (uint32_t i = 0; i < m_fields.size(); ++i) {
+    const Field& field = m_fields[i];
+    if (!field.prop) {
+      continue;
+    }
+    const PropertyHandle handle{m_builder, i};
+    if (field.size) {
+      alignas(8) char value[8];
+      std::memcpy(value, field.column + row * field.size, field.size);
+      if (field.prop->hasType<bool>() && static_cast<uint8_t>(value[0]) > 1) {
+        result = false;
+      } else if (field.prop->ops->setTyped(field.prop, obj, value)) {
+        obj->markChanged(handle);
+      } else {
+        result = false;
+      }
+    } else {
+      std::string_view text;
+      result &= getText(row, handle, &text) && obj->set(handle, text);
+    }
+  }
+  return result;
+}
+
+} // namespace meta
@@ -0,0 +1,149 @@
+// Copyright (c) 2020 Tiaan Louw
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "meta/meta_stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace meta {
+
+namespace {
+
+size_t roundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+} // namespace
+
+ChangeStream::ChangeStream(size_t capacity)
+    : m_slots(std::make_unique<Slot[]>(roundUpToPowerOfTwo(capacity))),
+      m_mask(roundUpToPowerOfTwo(capacity) - 1) {
+  for (size_t i = 0; i <= m_mask; ++i) {
+    for (std::atomic<uint64_t>& word : m_slots[i].value) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+ChangeStream::~ChangeStream() {
+  for (MetaObject* obj : m_watched) {
+    obj->removeChangeListener(this);
+  }
+}
+
+void ChangeStream::watch(MetaObject* obj) {
+  assert(obj);
+  if (std::find(m_watched.begin(), m_watched.end(), obj) == m_watched.end()) {
+    m_watched.push_back(obj);
+    obj->addChangeListener(this);
+  }
+}
+
+void ChangeStream::unwatch(MetaObject* obj) {
+  auto it = std::find(m_watched.begin(), m_watched.end(), obj);
+  if (it != m_watched.end()) {
+    m_watched.erase(it);
+    obj->removeChangeListener(this);
+  }
+}
+
+void ChangeStream::propertyChanged(MetaObject* obj, PropertyHandle handle) {
+  // Encode before touching the slot, so that the slot is unstable for as short as possible.
+  uint64_t value[kValueWords] = {};
+  detail::BufferWriter writer{reinterpret_cast<char*>(value), sizeof(value)};
+  obj->get(handle, AppendSink{&writer});
+
+  const uint64_t position = m_head.load(std::memory_order_relaxed);
+  Slot& slot = m_slots[position & m_mask];
+  slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.object.store(obj, std::memory_order_relaxed);
+  slot.builder.store(handle.builder, std::memory_order_relaxed);
+  slot.indexAndSize.store(handle.index | (static_cast<uint64_t>(writer.length) << 32),
+                          std::memory_order_relaxed);
+  for (size_t i = 0; i < kValueWords; ++i) {
+    slot.value[i].store(value[i], std::memory_order_relaxed);
+  }
+
+  slot.sequence.store(2 * position + 2, std::memory_order_release);
+  m_head.store(position + 1, std::memory_order_release);
+}
+
+void ChangeStream::objectDestroyed(MetaObject* obj) {
+  m_watched.erase(std::remove(m_watched.begin(), m_watched.end(), obj), m_watched.end());
+}
+
+ChangeStream::Consumer::Consumer(const ChangeStream& stream)
+    : m_stream(&stream), m_cursor(stream.m_head.load(std::memory_order_acquire)) {}
+
+bool ChangeStream::Consumer::poll(ChangeRecord* outRecord) {
+  assert(outRecord);
+
+  const size_t capacity = m_stream->m_mask + 1;
+  for (;;) {
+    const uint64_t head = m_stream->m_head.load(std::memory_order_acquire);
+    if (m_cursor == head) {
+      return false;
+    }
+    if (head - m_cursor > capacity) {
+      // Lapped by the producer; skip to the oldest record that is still there.
+      m_dropped += head - capacity - m_cursor;
+      m_cursor = head - capacity;
+    }
+
+    const Slot& slot = m_stream->m_slots[m_cursor & m_stream->m_mask];
+    const uint64_t expected = 2 * m_cursor + 2;
+    const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before != expected) {
+      // The slot is being reused for a later record; catch up on the next pass.
+      continue;
+    }
+
+    MetaObject* object = slot.object.load(std::memory_order_relaxed);
+    const MetaBuilder* builder = slot.builder.load(std::memory_order_relaxed);
+    const uint64_t indexAndSize = slot.indexAndSize.load(std::memory_order_relaxed);
+    uint64_t value[kValueWords];
+    for (size_t i = 0; i < kValueWords; ++i) {
+      value[i] = slot.value[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != before) {
+      continue;
+    }
+
+    const size_t size = static_cast<size_t>(indexAndSize >> 32);
+    outRecord->object = object;
+    outRecord->property = PropertyHandle{builder, static_cast<uint32_t>(indexAndSize)};
+    outRecord->valueSize = std::min(size, ChangeRecord::kMaxValueSize);
+    outRecord->truncated = size > ChangeRecord::kMaxValueSize;
+    std::memcpy(outRecord->value, value, outRecord->valueSize);
+    ++m_cursor;
+    return true;
+  }
+}
+
+} // namespace meta
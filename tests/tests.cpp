@@ -18,10 +18,24 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <utility>
+#include <vector>
 
 #include "meta/meta.h"
+#include "meta/meta_binary.h"
+#include "meta/meta_index.h"
+#include "meta/meta_json.h"
+#include "meta/meta_notify.h"
+#include "meta/meta_parallel.h"
+#include "meta/meta_query.h"
+#include "meta/meta_store.h"
+#include "meta/meta_stream.h"
 
 class Obj : public meta::MetaObject {
   DECLARE_META_OBJECT(Obj);
@@ -76,6 +90,111 @@ DEFINE_META_OBJECT(AnotherObj)
                                    meta::PropertyEditorType::String, &AnotherObj::isVisible,
                                    &AnotherObj::setVisible);
 
+class StaticObj : public meta::MetaObject {
+  DECLARE_META_OBJECT(StaticObj);
+
+public:
+  int getCount() const {
+    return m_count;
+  }
+  void setCount(int value) {
+    m_count = value;
+  }
+
+  double getScale() const {
+    return m_scale;
+  }
+
+private:
+  int m_count = 0;
+  double m_scale = 1.5;
+};
+
+DEFINE_STATIC_META_OBJECT(
+    StaticObj,
+    meta::staticProperty<StaticObj, int, &StaticObj::getCount, &StaticObj::setCount>(
+        "count", "count description", meta::PropertyEditorType::Integer),
+    meta::staticProperty<StaticObj, double, &StaticObj::getScale>(
+        "scale", "scale description", meta::PropertyEditorType::String));
+
+class StaticDerivedObj : public StaticObj {
+  DECLARE_META_OBJECT(StaticDerivedObj);
+
+public:
+  bool isVisible() const {
+    return m_visible;
+  }
+  void setVisible(bool visible) {
+    m_visible = visible;
+  }
+
+private:
+  bool m_visible = false;
+};
+
+DEFINE_STATIC_DERIVED_META_OBJECT(
+    StaticDerivedObj, StaticObj,
+    meta::staticProperty<StaticDerivedObj, bool, &StaticDerivedObj::isVisible,
+                         &StaticDerivedObj::setVisible>("visible", "visible description",
+                                                        meta::PropertyEditorType::Bool));
+
+// A static table with many properties, "w000" to "w299", to keep compile time lookup tables cheap.
+constexpr size_t kWideCount = 300;
+
+struct WideNames {
+  char text[kWideCount][4];
+};
+
+constexpr WideNames kWideNames = []() {
+  WideNames names{};
+  for (size_t i = 0; i < kWideCount; ++i) {
+    names.text[i][0] = 'w';
+    names.text[i][1] = static_cast<char>('0' + i / 100);
+    names.text[i][2] = static_cast<char>('0' + i / 10 % 10);
+    names.text[i][3] = static_cast<char>('0' + i % 10);
+  }
+  return names;
+}();
+
+template <size_t... I>
+constexpr std::array<meta::MetaEntry, sizeof...(I)> makeWideEntries(std::index_sequence<I...>) {
+  return {meta::staticProperty<StaticObj, int, &StaticObj::getCount, &StaticObj::setCount>(
+      std::string_view{kWideNames.text[I], 4}, "", meta::PropertyEditorType::Integer)...};
+}
+
+constexpr auto kWideEntries = makeWideEntries(std::make_index_sequence<kWideCount>{});
+using WideTable = meta::StaticMetaTable<kWideEntries>;
+static_assert(WideTable::kLayout.slots.size() <= 3 * kWideCount);
+
+class Note : public meta::MetaObject {
+  DECLARE_META_OBJECT(Note);
+
+public:
+  const std::string& getText() const {
+    return m_text;
+  }
+  void setText(const std::string& text) {
+    m_text = text;
+  }
+
+  double getWeight() const {
+    return m_weight;
+  }
+  void setWeight(double weight) {
+    m_weight = weight;
+  }
+
+private:
+  std::string m_text;
+  double m_weight = 0.0;
+};
+
+DEFINE_META_OBJECT(Note)
+    .addProperty<Note, std::string>("text", "text description", meta::PropertyEditorType::String,
+                                    &Note::getText, &Note::setText)
+    .addProperty<Note, double>("weight", "weight description", meta::PropertyEditorType::String,
+                               &Note::getWeight, &Note::setWeight);
+
 int main() {
   Obj obj("obj1");
 
@@ -92,6 +211,32 @@ int main() {
   assert(obj.get("count", &testValue));
   assert(std::string("50") == testValue);
 
+  assert(obj.set("count", " -7"));
+  assert(-7 == obj.getCount());
+  assert(!obj.set("count", "seven"));
+  assert(-7 == obj.getCount());
+  assert(obj.set("count", "50"));
+
+  // Values can be set straight from a slice of a larger buffer.
+  [[maybe_unused]] const std::string_view input = "count=123;visible=true";
+  assert(obj.set(input.substr(0, 5), input.substr(6, 3)));
+  assert(123 == obj.getCount());
+  assert(obj.set("count", "50"));
+
+  std::string numberValue;
+  assert(meta::detail::MetaConverter<double>::ToString(0.1, &numberValue));
+  assert(std::string("0.1") == numberValue);
+  [[maybe_unused]] double parsedDouble = 0.0;
+  assert(meta::detail::MetaConverter<double>::FromString("2.5e3", &parsedDouble));
+  assert(2500.0 == parsedDouble);
+  std::string parsedString;
+  assert(meta::detail::MetaConverter<std::string>::FromString("two words", &parsedString));
+  assert(std::string("two words") == parsedString);
+  [[maybe_unused]] unsigned long long parsedULL = 0;
+  assert(meta::detail::MetaConverter<unsigned long long>::FromString("18446744073709551615",
+                                                                     &parsedULL));
+  assert(18446744073709551615ull == parsedULL);
+
   AnotherObj anotherObj("anotherObj1");
 
   assert(anotherObj.get("name", &testValue));
@@ -105,5 +250,528 @@ int main() {
   assert(anotherObj.get("visible", &testValue));
   assert(std::string("false") == testValue);
 
+  assert(!anotherObj.get("missing", &testValue));
+  assert(Obj::GetStaticMetaBuilder()->isFrozen());
+
+  // A frozen builder with many properties still resolves every name to its own entry.
+  meta::MetaBuilder bigBuilder;
+  std::vector<std::string> names;
+  for (int i = 0; i < 200; ++i) {
+    names.push_back("property" + std::to_string(i));
+    bigBuilder.addProperty<Obj, int>(names.back(), "", meta::PropertyEditorType::Integer,
+                                     &Obj::getCount, &Obj::setCount);
+  }
+  bigBuilder.freeze();
+  for (const auto& name : names) {
+    [[maybe_unused]] const meta::MetaEntry* entry = bigBuilder.getProperty(name);
+    assert(entry);
+    assert(entry->name == name);
+  }
+  assert(!bigBuilder.getProperty("property200"));
+
+  // The lookup table stays linear in the number of properties.
+  meta::MetaBuilder hugeBuilder;
+  std::vector<std::string> hugeNames;
+  for (int i = 0; i < 1000; ++i) {
+    hugeNames.push_back("huge" + std::to_string(i));
+  }
+  for (const auto& name : hugeNames) {
+    hugeBuilder.addProperty<Obj, int>(name, "", meta::PropertyEditorType::Integer, &Obj::getCount,
+                                      &Obj::setCount);
+  }
+  assert(hugeBuilder.getLookupSlotCount() <= 4 * hugeNames.size());
+  assert(bigBuilder.getLookupSlotCount() <= 4 * names.size());
+  for ([[maybe_unused]] const auto& name : hugeNames) {
+    assert(hugeBuilder.getProperty(name)->name == name);
+  }
+  assert(!hugeBuilder.getProperty("huge1000"));
+
+  // A copy of a builder owns its own properties and names.
+  meta::MetaBuilder copiedBuilder(bigBuilder);
+  [[maybe_unused]] const meta::MetaEntry* copiedEntry = copiedBuilder.getProperty("property7");
+  assert(copiedEntry && copiedEntry != bigBuilder.getProperty("property7"));
+  assert(copiedEntry->name == "property7");
+  assert(copiedEntry->prop->set(&obj, "7"));
+  assert(7 == obj.getCount());
+
+  // Moving a builder, or initializing one from a chain on a temporary, keeps its properties.
+  [[maybe_unused]] const meta::MetaEntry* movedEntry = bigBuilder.getProperty("property7");
+  meta::MetaBuilder movedBuilder(std::move(bigBuilder));
+  assert(movedBuilder.getProperty("property7") == movedEntry);
+  const meta::MetaBuilder chainedBuilder =
+      meta::MetaBuilder{}.addProperty<Obj, int>("count", "", meta::PropertyEditorType::Integer,
+                                                &Obj::getCount, &Obj::setCount);
+  assert(chainedBuilder.getProperty("count"));
+
+  // Inherited properties are merged into the derived table and can be shadowed.
+  meta::MetaBuilder shadowBuilder;
+  shadowBuilder.addBase(AnotherObj::GetStaticMetaBuilder())
+      .addProperty<Obj, int>("name", "shadowed name", meta::PropertyEditorType::Integer,
+                             &Obj::getCount, &Obj::setCount);
+  assert(shadowBuilder.getProperty("name")->description == "shadowed name");
+  assert(shadowBuilder.getProperty("count") == Obj::GetStaticMetaBuilder()->getProperty("count"));
+  assert(shadowBuilder.getProperty("visible"));
+
+  // Handles skip the name lookup on repeated access.
+  [[maybe_unused]] meta::PropertyHandle countHandle =
+      AnotherObj::GetStaticMetaBuilder()->resolve("count");
+  assert(countHandle);
+  assert(anotherObj.set(countHandle, "42"));
+  assert(42 == anotherObj.getCount());
+  assert(anotherObj.get(countHandle, &testValue));
+  assert(std::string("42") == testValue);
+  assert(!AnotherObj::GetStaticMetaBuilder()->resolve("missing"));
+  assert(!anotherObj.get(meta::PropertyHandle{}, &testValue));
+
+  // Values can be appended to a sink or written into a buffer without a string per value.
+  std::string output;
+  assert(anotherObj.get("name", meta::AppendSink{&output}));
+  output.append("=");
+  assert(anotherObj.get(countHandle, meta::AppendSink{&output}));
+  assert(std::string("anotherObj1=42") == output);
+  assert(!anotherObj.get("missing", meta::AppendSink{&output}));
+
+  [[maybe_unused]] char buffer[8];
+  [[maybe_unused]] size_t length = 0;
+  assert(anotherObj.get(countHandle, buffer, sizeof(buffer), &length));
+  assert(std::string_view("42") == std::string_view(buffer, length));
+  assert(!anotherObj.get("name", buffer, 4, &length));
+  assert(11 == length);
+
+  // Typed access skips the string conversion, but only for the exact registered type.
+  [[maybe_unused]] int typedCount = 0;
+  assert(anotherObj.get(countHandle, &typedCount));
+  assert(42 == typedCount);
+  assert(anotherObj.set("count", 17));
+  assert(17 == anotherObj.getCount());
+  assert(anotherObj.set<int>(countHandle, 42));
+  [[maybe_unused]] long wrongType = 0;
+  assert(!anotherObj.get(countHandle, &wrongType));
+  assert(!anotherObj.set(countHandle, 1.5));
+  assert(42 == anotherObj.getCount());
+  [[maybe_unused]] bool typedVisible = true;
+  assert(anotherObj.get("visible", &typedVisible));
+  assert(!typedVisible);
+  std::string typedName;
+  assert(anotherObj.get<std::string>("name", &typedName));
+  assert(std::string("anotherObj1") == typedName);
+  assert(!anotherObj.set<int>("name", 1));
+  assert(!anotherObj.set("missing", 1));
+
+  // Names hashed at compile time.
+  using namespace meta::literals;
+  constexpr meta::PropertyName visibleName = "visible"_prop;
+  static_assert(visibleName.hash == meta::detail::hashName("visible"));
+  assert(anotherObj.set(visibleName, "true"));
+  assert(anotherObj.isVisible());
+  assert(anotherObj.get("count"_prop, &testValue));
+  assert(std::string("42") == testValue);
+  assert(AnotherObj::GetStaticMetaBuilder()->getProperty("name"_prop));
+  assert(!AnotherObj::GetStaticMetaBuilder()->getProperty("missing"_prop));
+
+  // The whole name is hashed and compared, embedded NUL characters included.
+  static_assert(meta::detail::hashName(std::string_view{"count\0x", 7}) !=
+                meta::detail::hashName("count"));
+  assert(!anotherObj.get(std::string_view{"count\0x", 7}, &testValue));
+  assert(!anotherObj.get("coun", &testValue));
+
+  // Builders defined at compile time.
+  assert(StaticObj::GetStaticMetaBuilder()->isFrozen());
+  const meta::MetaBuilder wideBuilder{WideTable::kSchema};
+  for (size_t i = 0; i < kWideCount; ++i) {
+    const std::string_view name{kWideNames.text[i], 4};
+    assert(wideBuilder.getProperty(name) == &kWideEntries[i]);
+  }
+  assert(!wideBuilder.getProperty("w300"));
+
+  StaticDerivedObj staticObj;
+  assert(staticObj.set("count", "12"));
+  assert(12 == staticObj.getCount());
+  assert(staticObj.set("visible", "true"));
+  assert(staticObj.isVisible());
+  assert(staticObj.get("scale", &testValue));
+  assert(std::string("1.5") == testValue);
+  assert(!staticObj.set("scale", "2"));
+  assert(!staticObj.get("missing", &testValue));
+  assert(StaticObj::GetStaticMetaBuilder()->getProperty("count")->description ==
+         "count description");
+
+  // Binary round trip through the setters; read only properties are skipped.
+  meta::BinarySchema binarySchema(AnotherObj::GetStaticMetaBuilder());
+  AnotherObj binarySource("binary");
+  binarySource.setCount(-300);
+  binarySource.setVisible(true);
+  std::string binaryData;
+  assert(binarySchema.write(&binarySource, &binaryData));
+  AnotherObj binaryTarget("target");
+  assert(binarySchema.read(&binaryTarget, binaryData));
+  assert(-300 == binaryTarget.getCount());
+  assert(binaryTarget.isVisible());
+  assert(std::string("target") == binaryTarget.getName());
+  assert(!binarySchema.read(&binaryTarget, std::string_view{binaryData}.substr(0, 10)));
+  meta::BinarySchema staticSchema(StaticDerivedObj::GetStaticMetaBuilder());
+  // Fingerprints are persisted, so they must never change for the same properties.
+  assert(0xf8a8488720f9a4b3ull == binarySchema.getFingerprint());
+  assert(staticSchema.getFingerprint() != binarySchema.getFingerprint());
+  std::string staticData;
+  assert(staticSchema.write(&staticObj, &staticData));
+  assert(!binarySchema.read(&binaryTarget, staticData));
+
+  // JSON is streamed straight from the getters and into the setters.
+  std::string json;
+  assert(meta::writeJson(&binarySource, meta::AppendSink{&json}));
+  assert(json == R"({"name":"binary","count":-300,"visible":true})");
+  AnotherObj jsonTarget("json");
+  assert(meta::readJson(&jsonTarget, json));
+  assert(-300 == jsonTarget.getCount());
+  assert(std::string("json") == jsonTarget.getName());
+  assert(meta::readJson(&jsonTarget, " { \"visible\" : true, \"count\": 7 } "));
+  assert(7 == jsonTarget.getCount());
+  assert(jsonTarget.isVisible());
+  assert(!meta::readJson(&jsonTarget, R"({"name":"x"})", nullptr, meta::ReadOnlyKeys::Reject));
+  assert(!meta::readJson(&jsonTarget, R"({"missing":1})"));
+  assert(!meta::readJson(&jsonTarget, R"({"count":[1]})"));
+  assert(!meta::readJson(&jsonTarget, R"({"count":1} x)"));
+  assert(!meta::readJson(&jsonTarget, R"({"count":1e3})"));
+  assert(!meta::readJson(&jsonTarget, R"({"count":1.9})"));
+  assert(1 == jsonTarget.getCount());
+  [[maybe_unused]] size_t jsonConsumed = 0;
+  assert(meta::readJson(&jsonTarget, R"({"count":8},{"count":9})", &jsonConsumed));
+  assert(11 == jsonConsumed);
+  Note note;
+  note.setText("a \"quoted\"\n\x01 line");
+  note.setWeight(0.5);
+  json.clear();
+  assert(meta::writeJson(&note, meta::AppendSink{&json}));
+  assert(json == R"({"text":"a \"quoted\"\n\u0001 line","weight":0.5})");
+  Note jsonNote;
+  assert(meta::readJson(&jsonNote, json));
+  assert(jsonNote.getText() == note.getText());
+  assert(0.5 == jsonNote.getWeight());
+  assert(meta::readJson(&jsonNote, R"({"text":"\u00e9\ud83d\ude00"})"));
+  assert(jsonNote.getText() == "\xc3\xa9\xf0\x9f\x98\x80");
+
+  // Snapshots hold every value, inherited and read only ones included, and can be restored.
+  const meta::MetaBuilder* anotherBuilder = AnotherObj::GetStaticMetaBuilder();
+  meta::Snapshot snapshot;
+  assert(anotherBuilder->snapshot(&binarySource, &snapshot));
+  assert(3 == snapshot.size());
+  assert(snapshot.getValue(anotherBuilder->resolve("name")) == "binary");
+  assert(snapshot.getValue(anotherBuilder->resolve("count")) == "-300");
+  assert(snapshot.getValue(anotherBuilder->resolve("visible")) == "true");
+  AnotherObj restored("restored");
+  assert(anotherBuilder->restore(&restored, snapshot));
+  assert(-300 == restored.getCount());
+  assert(restored.isVisible());
+  assert(std::string("restored") == restored.getName());
+  assert(anotherBuilder->snapshot(&restored, &snapshot));
+  assert(snapshot.getValue(anotherBuilder->resolve("name")) == "restored");
+
+  // A patch holds the writable properties that differ and can be applied to any other object.
+  AnotherObj diffFrom("from");
+  AnotherObj diffTo("to");
+  diffFrom.setCount(1);
+  diffTo.setCount(2);
+  meta::Patch patch;
+  assert(anotherBuilder->diff(&diffFrom, &diffTo, &patch));
+  assert(1 == patch.size());
+  assert(patch.getHandle(0).index == anotherBuilder->resolve("count").index);
+  assert(patch.getValue(0) == "2");
+  AnotherObj patched("patched");
+  patched.setVisible(true);
+  assert(anotherBuilder->apply(&patched, patch));
+  assert(2 == patched.getCount());
+  assert(patched.isVisible());
+  assert(anotherBuilder->diff(&diffTo, &patched, &patch));
+  assert(1 == patch.size() && patch.getValue(0) == "true");
+  assert(anotherBuilder->diff(&patched, &patched, &patch));
+  assert(patch.empty());
+
+  // Successful sets mark their property dirty once tracking is enabled.
+  AnotherObj tracked("tracked");
+  [[maybe_unused]] const meta::PropertyHandle visibleHandle = anotherBuilder->resolve("visible");
+  const meta::PropertyHandle anotherCountHandle = anotherBuilder->resolve("count");
+  assert(tracked.set("visible", "true"));
+  assert(!tracked.isDirtyTrackingEnabled() && !tracked.isDirty(visibleHandle));
+  tracked.enableDirtyTracking();
+  assert(tracked.isDirtyTrackingEnabled());
+  assert(tracked.set("visible", "false"));
+  assert(tracked.set(anotherCountHandle, 3));
+  assert(!tracked.set("name", "other"));
+  assert(!tracked.set("count", "x"));
+  std::vector<uint32_t> dirtyIndices;
+  tracked.forEachDirty([&](meta::PropertyHandle handle) { dirtyIndices.push_back(handle.index); });
+  assert((dirtyIndices == std::vector<uint32_t>{anotherCountHandle.index, visibleHandle.index}));
+  assert(!tracked.isDirty(anotherBuilder->resolve("name")));
+  tracked.clearDirty();
+  assert(!tracked.isDirty(visibleHandle) && !tracked.isDirty(anotherCountHandle));
+  assert(anotherBuilder->restore(&tracked, snapshot));
+  assert(tracked.isDirty(visibleHandle));
+  const AnotherObj trackedCopy(tracked);
+  assert(!trackedCopy.isDirtyTrackingEnabled());
+
+  // Changes are queued, coalesced and delivered on flush.
+  {
+    meta::ChangeNotifier notifier;
+    AnotherObj watched("watched");
+    std::vector<uint32_t> objectChanges;
+    int countChanges = 0;
+    notifier.subscribe(&watched,
+                       [&]([[maybe_unused]] meta::MetaObject* obj, meta::PropertyHandle handle) {
+                         assert(obj == &watched);
+                         objectChanges.push_back(handle.index);
+                       });
+    const meta::ChangeNotifier::SubscriptionId countSubscription = notifier.subscribe(
+        &watched, anotherCountHandle, [&](meta::MetaObject*, meta::PropertyHandle) {
+          ++countChanges;
+        });
+    assert(!notifier.hasPending());
+    for (int i = 0; i < 10; ++i) {
+      assert(watched.set(anotherCountHandle, i));
+    }
+    assert(watched.set("visible", "true"));
+    assert(objectChanges.empty() && 0 == countChanges);
+    notifier.flush();
+    assert((objectChanges == std::vector<uint32_t>{anotherCountHandle.index, visibleHandle.index}));
+    assert(1 == countChanges);
+    notifier.unsubscribe(countSubscription);
+    assert(watched.set(anotherCountHandle, 20));
+    notifier.flush();
+    assert(3 == objectChanges.size() && 1 == countChanges);
+    {
+      AnotherObj shortLived("short");
+      notifier.subscribe(&shortLived,
+                         [](meta::MetaObject*, meta::PropertyHandle) { assert(false); });
+      assert(shortLived.set("count", "1"));
+      assert(notifier.hasPending());
+    }
+    assert(!notifier.hasPending());
+    notifier.flush();
+  }
+
+  // Every consumer of a change stream sees every record, unless it falls a whole ring behind.
+  {
+    meta::ChangeStream stream(3);
+    assert(4 == stream.getCapacity());
+    AnotherObj streamed("streamed");
+    stream.watch(&streamed);
+    meta::ChangeStream::Consumer first(stream);
+    meta::ChangeStream::Consumer second(stream);
+    meta::ChangeRecord record;
+    assert(!first.poll(&record));
+    assert(streamed.set(anotherCountHandle, 5));
+    assert(streamed.set("visible", "true"));
+    assert(first.poll(&record));
+    assert(record.object == &streamed && record.property.index == anotherCountHandle.index);
+    assert(record.getValue() == "5" && !record.truncated);
+    assert(first.poll(&record));
+    assert(record.property.index == visibleHandle.index && record.getValue() == "true");
+    assert(!first.poll(&record));
+    for (int i = 0; i < 5; ++i) {
+      assert(streamed.set(anotherCountHandle, 10 + i));
+    }
+    assert(second.poll(&record));
+    assert(3 == second.getDropped());
+    assert(record.getValue() == "11");
+    stream.unwatch(&streamed);
+    assert(streamed.set(anotherCountHandle, 99));
+    int remaining = 0;
+    while (second.poll(&record)) {
+      ++remaining;
+    }
+    assert(3 == remaining && record.getValue() == "14");
+  }
+
+  // One property of many objects at once, straight into a typed column.
+  {
+    std::vector<AnotherObj> columnObjs(5, AnotherObj("column"));
+    std::vector<meta::MetaObject*> columnPtrs;
+    for (size_t i = 0; i < columnObjs.size(); ++i) {
+      columnObjs[i].setCount(static_cast<int>(i * i));
+      columnObjs[i].setVisible(i % 2 == 0);
+      columnPtrs.push_back(&columnObjs[i]);
+    }
+    std::vector<int> counts;
+    assert(anotherBuilder->getColumn(anotherCountHandle, columnPtrs, &counts));
+    assert((counts == std::vector<int>{0, 1, 4, 9, 16}));
+    [[maybe_unused]] bool visibles[5];
+    assert(anotherBuilder->getColumn(visibleHandle, columnPtrs.data(), 5, visibles));
+    assert(visibles[0] && !visibles[1] && visibles[4]);
+    std::vector<double> wrongType;
+    assert(!anotherBuilder->getColumn(anotherCountHandle, columnPtrs, &wrongType));
+  }
+
+  // Bulk set converts once per type, resolves once per builder and splits the work between threads.
+  {
+    meta::ThreadPool pool(4);
+    std::vector<int> visits(10'000, 0);
+    pool.parallelFor(visits.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        ++visits[i];
+      }
+    });
+    assert(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+
+    std::vector<AnotherObj> bulkAnother(1'000, AnotherObj("bulk"));
+    std::vector<Obj> bulkObj(500, Obj("bulk"));
+    std::vector<meta::MetaObject*> bulkPtrs;
+    for (size_t i = 0; i < bulkAnother.size(); ++i) {
+      bulkPtrs.push_back(&bulkAnother[i]);
+      if (i < bulkObj.size()) {
+        bulkPtrs.push_back(&bulkObj[i]);
+      }
+    }
+    bulkAnother[7].enableDirtyTracking();
+    assert(meta::bulkSet(&pool, bulkPtrs, "count", "77"));
+    assert(std::all_of(bulkAnother.begin(), bulkAnother.end(),
+                       [](const AnotherObj& o) { return o.getCount() == 77; }));
+    assert(std::all_of(bulkObj.begin(), bulkObj.end(),
+                       [](const Obj& o) { return o.getCount() == 77; }));
+    assert(bulkAnother[7].isDirty(anotherCountHandle));
+    assert(!meta::bulkSet(&pool, bulkPtrs, "count", "x"));
+    assert(!meta::bulkSet(&pool, bulkPtrs, "visible", "true"));
+    assert(!meta::bulkSet(&pool, bulkPtrs, "name", "x"));
+    assert(!bulkAnother[0].isVisible() && 77 == bulkObj[0].getCount());
+  }
+
+  // Queries compare typed columns block by block.
+  {
+    std::vector<AnotherObj> queryObjs(600, AnotherObj("query"));
+    std::vector<meta::MetaObject*> queryPtrs;
+    for (size_t i = 0; i < queryObjs.size(); ++i) {
+      queryObjs[i].setCount(static_cast<int>(i));
+      queryObjs[i].setVisible(i % 3 == 0);
+      queryPtrs.push_back(&queryObjs[i]);
+    }
+    const meta::Query query = meta::Query(anotherBuilder)
+                                  .where("count", meta::CompareOp::Greater, 50)
+                                  .where("visible", meta::CompareOp::Equal, true);
+    assert(query.isValid());
+    std::vector<meta::MetaObject*> matches;
+    assert(query.run(queryPtrs, &matches));
+    assert(183 == matches.size());
+    assert(matches.front() == &queryObjs[51] && matches.back() == &queryObjs[597]);
+    matches.clear();
+    assert(meta::Query(anotherBuilder)
+               .where("name", meta::CompareOp::Equal, "query")
+               .where("count", meta::CompareOp::LessEqual, 1)
+               .run(queryPtrs, &matches));
+    assert(2 == matches.size());
+    const meta::Query byHandle = meta::Query(anotherBuilder)
+                                     .where(anotherBuilder->resolve("name"),
+                                            meta::CompareOp::Equal, "query");
+    assert(byHandle.isValid());
+    matches.clear();
+    assert(byHandle.run(queryPtrs, &matches));
+    assert(600 == matches.size());
+    assert(!meta::Query(anotherBuilder).where("count", meta::CompareOp::Less, 1.0).isValid());
+    assert(!meta::Query(anotherBuilder).where("missing", meta::CompareOp::Less, 1).isValid());
+  }
+
+  // Indexes follow every set of the objects they hold.
+  {
+    meta::HashIndex<int> byCount(anotherBuilder, "count");
+    meta::OrderedIndex<int> byCountOrdered(anotherBuilder, "count");
+    assert(byCount.isValid() && byCountOrdered.isValid());
+    assert(!meta::HashIndex<double>(anotherBuilder, "count").isValid());
+    assert(!meta::OrderedIndex<int>(anotherBuilder, "missing").isValid());
+
+    std::vector<AnotherObj> indexed(10, AnotherObj("indexed"));
+    for (size_t i = 0; i < indexed.size(); ++i) {
+      indexed[i].setCount(static_cast<int>(i % 5));
+      assert(byCount.add(&indexed[i]) && byCountOrdered.add(&indexed[i]));
+    }
+    assert(10 == byCount.size() && 2 == byCount.count(3));
+    std::vector<meta::MetaObject*> found;
+    byCountOrdered.findRange(1, 2, &found);
+    assert((found == std::vector<meta::MetaObject*>{&indexed[1], &indexed[6], &indexed[2],
+                                                    &indexed[7]}));
+
+    assert(indexed[3].set("count", "40"));
+    assert(indexed[1].set(visibleHandle, true));
+    assert(1 == byCount.count(3) && 1 == byCount.count(40));
+    found.clear();
+    byCountOrdered.find(40, &found);
+    assert((found == std::vector<meta::MetaObject*>{&indexed[3]}));
+
+    byCount.remove(&indexed[8]);
+    assert(9 == byCount.size() && 0 == byCount.count(3));
+    {
+      AnotherObj temporary("temporary");
+      temporary.setCount(3);
+      byCount.add(&temporary);
+      assert(1 == byCount.count(3));
+    }
+    assert(0 == byCount.count(3) && 9 == byCount.size());
+  }
+
+  // Stores are mapped and read in place; objects are only filled in when loaded.
+#if defined(__unix__) || defined(__APPLE__)
+  {
+    const std::string storePath = "string_properties_test_store.bin";
+    std::vector<Note> storedNotes(3);
+    std::vector<meta::MetaObject*> storedPtrs;
+    for (size_t i = 0; i < storedNotes.size(); ++i) {
+      storedNotes[i].setText(std::string(i * 10, 'x'));
+      storedNotes[i].setWeight(0.5 * static_cast<double>(i));
+      storedPtrs.push_back(&storedNotes[i]);
+    }
+    [[maybe_unused]] const meta::MetaBuilder* noteBuilder = Note::GetStaticMetaBuilder();
+    assert(meta::PropertyStore::write(storePath, noteBuilder, storedPtrs));
+
+    meta::PropertyStore store;
+    assert(!store.open(storePath, anotherBuilder));
+    assert(store.open(storePath, noteBuilder));
+    assert(3 == store.size());
+    [[maybe_unused]] double storedWeight = 0.0;
+    assert(store.get(2, noteBuilder->resolve("weight"), &storedWeight));
+    assert(1.0 == storedWeight);
+    std::string_view storedText;
+    assert(store.getText(1, noteBuilder->resolve("text"), &storedText));
+    assert(storedText == std::string(10, 'x'));
+    assert(!store.get(2, noteBuilder->resolve("weight"), &storedText));
+
+    Note loaded;
+    loaded.enableDirtyTracking();
+    assert(store.load(2, &loaded));
+    assert(loaded.getText() == storedNotes[2].getText() && 1.0 == loaded.getWeight());
+    assert(loaded.isDirty(noteBuilder->resolve("weight")));
+    store.close();
+
+    // A bool column byte other than 0 or 1 is rejected.  The byte is found as the only difference
+    // between stores that differ in one bool.
+    AnotherObj storedFlag("flag");
+    std::vector<meta::MetaObject*> flagPtrs{&storedFlag};
+    auto readFile = [&storePath]() {
+      std::ifstream in(storePath, std::ios::binary);
+      return std::string{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    };
+    assert(meta::PropertyStore::write(storePath, anotherBuilder, flagPtrs));
+    const std::string flagOff = readFile();
+    storedFlag.setVisible(true);
+    assert(meta::PropertyStore::write(storePath, anotherBuilder, flagPtrs));
+    std::string flagOn = readFile();
+    assert(flagOn.size() == flagOff.size());
+    const size_t flagByte = static_cast<size_t>(
+        std::mismatch(flagOn.begin(), flagOn.end(), flagOff.begin()).first - flagOn.begin());
+    assert(flagByte < flagOn.size() && 1 == flagOn[flagByte]);
+    flagOn[flagByte] = 2;
+    std::ofstream(storePath, std::ios::binary).write(flagOn.data(),
+                                                     static_cast<std::streamsize>(flagOn.size()));
+    assert(store.open(storePath, anotherBuilder));
+    [[maybe_unused]] bool storedVisible = false;
+    assert(!store.get(0, anotherBuilder->resolve("visible"), &storedVisible));
+    AnotherObj flagTarget("target");
+    assert(!store.load(0, &flagTarget));
+    assert(!flagTarget.isVisible());
+    store.close();
+    std::remove(storePath.c_str());
+  }
+#endif
+
+  std::set<std::string> propertyNames;
+  shadowBuilder.getListOfProperties(&propertyNames);
+  assert((propertyNames == std::set<std::string>{"count", "name", "visible"}));
+
   return 0;
 }